@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// disk_io.hpp
+//
+// Saving and loading disk_state rows, in a dense binary format and in the
+// "D L D L ..." text format of disk_state::to_string().
+//
+// Binary format: the 8 byte magic "DISKBIN1", the total number of disks as
+// an 8 byte little-endian integer, then the disks packed one bit each (set
+// for a light disk) into little-endian 64-bit words, disk i at bit i % 64
+// of word i / 64.
+//
+// Both formats go through fixed-size buffers so that rows of billions of
+// disks never need a second full copy in memory. Malformed input throws
+// std::runtime_error.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "disks.hpp"
+
+// Number of 64-bit words (binary) or characters (text) handled per block.
+const size_t DISK_IO_BLOCK = 1 << 16;
+
+namespace disk_io_detail {
+
+inline const char* binary_magic() {
+  return "DISKBIN1";
+}
+
+inline void put_u64(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    out[i] = uint8_t(value >> (8 * i));
+  }
+}
+
+inline uint64_t get_u64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value |= uint64_t(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+// The eight colors packed into each possible byte, so that unpacking
+// takes one table lookup per byte rather than one branch per disk.
+struct unpack_table {
+  disk_color colors[256][8];
+
+  unpack_table() {
+    for (unsigned byte = 0; byte < 256; ++byte) {
+      for (unsigned bit = 0; bit < 8; ++bit) {
+        colors[byte][bit] = ((byte >> bit) & 1) ? DISK_LIGHT : DISK_DARK;
+      }
+    }
+  }
+};
+
+inline const unpack_table& unpacker() {
+  static const unpack_table table;
+  return table;
+}
+
+// Class of each possible character in the text format: 0 and 1 are
+// colors, 2 is whitespace, 3 is anything else.
+struct text_table {
+  unsigned char classes[256];
+
+  text_table() {
+    std::memset(classes, 3, sizeof(classes));
+    classes[unsigned('D')] = DISK_DARK;
+    classes[unsigned('L')] = DISK_LIGHT;
+    for (char c : {' ', '\t', '\n', '\r'}) {
+      classes[unsigned(c)] = 2;
+    }
+  }
+};
+
+inline const text_table& text_classes() {
+  static const text_table table;
+  return table;
+}
+
+} // namespace disk_io_detail
+
+// Write disks in the binary format.
+void write_binary(std::ostream& out, const disk_state& disks) {
+  using namespace disk_io_detail;
+
+  const size_t total = disks.total_count();
+  uint8_t header[16];
+  std::memcpy(header, binary_magic(), 8);
+  put_u64(header + 8, total);
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+  std::vector<uint8_t> buffer(DISK_IO_BLOCK * 8);
+  for (size_t first = 0; first < total; first += DISK_IO_BLOCK * 64) {
+    size_t last = std::min(total, first + DISK_IO_BLOCK * 64);
+    size_t words = (last - first + 63) / 64;
+    for (size_t w = 0; w < words; ++w) {
+      uint64_t word = 0;
+      size_t base = first + w * 64, end = std::min(last, base + 64);
+      for (size_t i = base; i < end; ++i) {
+        word |= uint64_t(disks.get(i) == DISK_LIGHT) << (i - base);
+      }
+      put_u64(&buffer[w * 8], word);
+    }
+    out.write(reinterpret_cast<const char*>(buffer.data()), words * 8);
+  }
+
+  if (!out) {
+    throw std::runtime_error("failed writing disk row");
+  }
+}
+
+// Read a row written by write_binary.
+disk_state read_binary(std::istream& in) {
+  using namespace disk_io_detail;
+
+  uint8_t header[16];
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header))
+      || std::memcmp(header, binary_magic(), 8) != 0) {
+    throw std::runtime_error("not a binary disk row");
+  }
+  const uint64_t total = get_u64(header + 8);
+  if (total == 0 || total % 2 != 0) {
+    throw std::runtime_error("disk row must have a positive, even length");
+  }
+
+  const auto& table = unpacker().colors;
+  // grown one block at a time as the data arrives, rather than sized from
+  // the header, so that a corrupt count cannot trigger a huge allocation
+  std::vector<disk_color> colors;
+
+  std::vector<uint8_t> buffer(DISK_IO_BLOCK * 8);
+  size_t lights = 0;
+  for (uint64_t first = 0; first < total; first += DISK_IO_BLOCK * 64) {
+    size_t count = size_t(std::min<uint64_t>(total - first, DISK_IO_BLOCK * 64));
+    size_t bytes = (count + 63) / 64 * 8;
+    if (!in.read(reinterpret_cast<char*>(buffer.data()), bytes)) {
+      throw std::runtime_error("truncated binary disk row");
+    }
+    colors.resize(colors.size() + count);
+    for (size_t b = 0; b < bytes; ++b) {
+      size_t base = first + b * 8;
+      if (base >= total) {
+        if (buffer[b] != 0) {
+          throw std::runtime_error("nonzero padding in binary disk row");
+        }
+        continue;
+      }
+      size_t n = std::min<size_t>(8, total - base);
+      if (n < 8 && (buffer[b] >> n) != 0) {
+        throw std::runtime_error("nonzero padding in binary disk row");
+      }
+      std::memcpy(&colors[base], table[buffer[b]], n * sizeof(disk_color));
+      lights += __builtin_popcount(buffer[b]);
+    }
+  }
+
+  if (lights * 2 != total) {
+    throw std::runtime_error("disk row must be half light and half dark");
+  }
+  return disk_state(std::move(colors));
+}
+
+// Write disks in the text format of disk_state::to_string(), followed by
+// a newline.
+void write_text(std::ostream& out, const disk_state& disks) {
+  static const char letters[2] = {'D', 'L'};
+  static_assert(DISK_DARK == 0 && DISK_LIGHT == 1, "letters[] is indexed by color");
+
+  std::vector<char> buffer(DISK_IO_BLOCK);
+  size_t used = 0;
+  for (size_t i = 0; i < disks.total_count(); ++i) {
+    if (used + 2 > buffer.size()) {
+      out.write(buffer.data(), used);
+      used = 0;
+    }
+    buffer[used++] = letters[disks.get(i)];
+    buffer[used++] = (i + 1 < disks.total_count()) ? ' ' : '\n';
+  }
+  out.write(buffer.data(), used);
+
+  if (!out) {
+    throw std::runtime_error("failed writing disk row");
+  }
+}
+
+// Read a row in the text format: the letters D and L, optionally
+// separated by whitespace, up to the end of the input.
+disk_state read_text(std::istream& in) {
+  const auto& classes = disk_io_detail::text_classes().classes;
+
+  std::vector<disk_color> colors;
+  std::vector<char> buffer(DISK_IO_BLOCK);
+  size_t lights = 0;
+  while (in) {
+    in.read(buffer.data(), buffer.size());
+    size_t got = in.gcount();
+    for (size_t i = 0; i < got; ++i) {
+      unsigned char c = classes[static_cast<unsigned char>(buffer[i])];
+      if (c < 2) {
+        colors.push_back(disk_color(c));
+        lights += c;
+      } else if (c == 3) {
+        throw std::runtime_error("unexpected character in disk row");
+      }
+    }
+  }
+
+  if (colors.empty() || lights * 2 != colors.size()) {
+    throw std::runtime_error("disk row must be half light and half dark");
+  }
+  return disk_state(std::move(colors));
+}
+
+// Parse a string made by disk_state::to_string().
+disk_state disk_state_from_string(const std::string& text) {
+  std::istringstream in(text);
+  return read_text(in);
+}
@@ -1,35 +1,64 @@
 ///////////////////////////////////////////////////////////////////////////////
 // disks.hpp
 //
-// Definitions for two algorithms that each solve the alternating disks
+// Definitions for the algorithms that each solve the alternating disks
 // problem.
 //
-// As provided, this header has four functions marked with TODO comments.
-// You need to write in your own implementation of these functions.
+// The row of disks is a disk_state, and each algorithm returns the sorted
+// row and its swap count in a sorted_disks. There are three sorts:
+// left-to-right, lawnmower, and a parallel odd-even transposition sort.
+// Each sort comes in a copying form and an _in_place form that returns
+// only sort_counts. The two sequential sorts can also report every swap
+// to a trace. sort_batch sorts many rows over a work-stealing pool.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <cstddef>
-#include <sstream>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "work_stealing.hpp"
+
 // State of one disk, either light or dark.
 enum disk_color { DISK_DARK, DISK_LIGHT };
 
 // Data structure for the state of one row of disks.
+//
+// Besides the colors, a disk_state keeps three counters up to date on
+// every swap, so that is_sorted(), is_alternating() and inversion_count()
+// take constant time.
 class disk_state {
 private:
   std::vector<disk_color> _colors;
+  // light disks in the left half, at indices below light_count()
+  size_t _left_light_count;
+  // disks whose color differs from the alternating format
+  size_t _misplaced_count;
+  // pairs of a light disk somewhere left of a dark disk
+  size_t _inversion_count;
+
+  static disk_color alternating_color(size_t index) {
+    return (index % 2 == 1) ? DISK_LIGHT : DISK_DARK;
+  }
 
 public:
 
   disk_state(size_t light_count)
-    : _colors(light_count * 2, DISK_DARK) {
+    : _colors(light_count * 2, DISK_DARK),
+      _left_light_count(light_count / 2),
+      _misplaced_count(0),
+      _inversion_count(light_count * (light_count - 1) / 2) {
 
       assert(light_count > 0);
 
@@ -38,6 +67,16 @@ public:
       }
   }
 
+  // A row with the given colors, which must be half light and half dark.
+  explicit disk_state(std::vector<disk_color> colors)
+    : _colors(std::move(colors)) {
+
+      assert(!_colors.empty() && _colors.size() % 2 == 0);
+      recount();
+      assert(std::count(_colors.begin(), _colors.end(), DISK_LIGHT)
+             == std::ptrdiff_t(light_count()));
+  }
+
   // Equality operator for unit tests.
   bool operator== (const disk_state& rhs) const {
     return std::equal(_colors.begin(), _colors.end(), rhs._colors.begin());
@@ -68,105 +107,493 @@ public:
     assert(is_index(left_index));
     auto right_index = left_index + 1;
     assert(is_index(right_index));
+
+    auto left = _colors[left_index];
+    if (left == _colors[right_index]) {
+      return;
+    }
+
+    bool light_moves_right = (left == DISK_LIGHT);
+    if (light_moves_right) {
+      _inversion_count--;
+    } else {
+      _inversion_count++;
+    }
+
+    if (right_index == light_count()) {
+      if (light_moves_right) {
+        _left_light_count--;
+      } else {
+        _left_light_count++;
+      }
+    }
+
+    // both disks change color, and since neighboring indices expect
+    // opposite colors, either both were in place or both were misplaced
+    if (left == alternating_color(left_index)) {
+      _misplaced_count += 2;
+    } else {
+      _misplaced_count -= 2;
+    }
+
     std::swap(_colors[left_index], _colors[right_index]);
   }
 
-  std::string to_string() const {
-    std::stringstream ss;
-    bool first = true;
-    for (auto color : _colors) {
-      if (!first) {
-        ss << " ";
-      }
+  // Swap without updating the counters. This is for threads that swap
+  // disjoint pairs of the same row at once, which must call recount()
+  // when they are all done.
+  void swap_uncounted(size_t left_index) {
+    assert(is_index(left_index));
+    assert(is_index(left_index + 1));
+    std::swap(_colors[left_index], _colors[left_index + 1]);
+  }
 
-      if (color == DISK_LIGHT) {
-        ss << "L";
+  // Recompute the counters from the colors, in linear time.
+  void recount() {
+    _left_light_count = _misplaced_count = _inversion_count = 0;
+    size_t lights_seen = 0;
+    for (size_t i = 0; i < _colors.size(); i++) {
+      if (_colors[i] == DISK_LIGHT) {
+        lights_seen++;
+        if (i < light_count()) {
+          _left_light_count++;
+        }
       } else {
-        ss << "D";
+        _inversion_count += lights_seen;
+      }
+      if (_colors[i] != alternating_color(i)) {
+        _misplaced_count++;
       }
+    }
+  }
 
-      first = false;
+  // Number of light disks left of the middle of the row.
+  size_t left_light_count() const {
+    return _left_light_count;
+  }
+
+  // Number of disks out of place for the alternating format.
+  size_t misplaced_count() const {
+    return _misplaced_count;
+  }
+
+  // Number of (light, dark) pairs with the light disk on the left, which
+  // is also the number of swaps left until the row is sorted.
+  size_t inversion_count() const {
+    return _inversion_count;
+  }
+
+  // Colors as "D L D L ...", written straight into a string of the
+  // right size. disk_io.hpp has the matching parser.
+  std::string to_string() const {
+    std::string result(2 * _colors.size() - 1, ' ');
+    for (size_t i = 0; i < _colors.size(); i++) {
+      result[2 * i] = (_colors[i] == DISK_LIGHT) ? 'L' : 'D';
     }
-    return ss.str();
+    return result;
   }
 
   // Return true when this disk_state is in alternating format. That means
   // that the first disk at index 0 is dark, the second disk at index 1
   // is light, and so on for the entire row of disks.
   bool is_alternating() const {
-    for(size_t i = 1; i < _colors.size(); i+=2){
-      if(_colors[i] != DISK_LIGHT){
-        return false;
-      }
-    }
-
-    return true;
+    return _misplaced_count == 0;
   }
 
   // Return true when this disk_state is fully sorted, with all light disks
   // on the right (high indices) and all dark disks on the left (low
   // indices).
   bool is_sorted() const {
-    for(size_t i = 0; i < light_count(); i++){
-      if(_colors[i] == DISK_LIGHT){
-        return false;
-      }
-    }
-
-    return true;
+    return _left_light_count == 0;
   }
 };
 
 // Data structure for the output of the alternating disks problem. That
 // includes both the final disk_state, as well as a count of the number
-// of swaps performed.
+// of swaps performed and the number of passes over the row it took.
 class sorted_disks {
 private:
   disk_state _after;
-  unsigned _swap_count;
+  uint64_t _swap_count;
+  uint64_t _pass_count;
 
 public:
 
-  sorted_disks(const disk_state& after, unsigned swap_count)
-    : _after(after), _swap_count(swap_count) { }
+  sorted_disks(const disk_state& after, uint64_t swap_count,
+               uint64_t pass_count = 0)
+    : _after(after), _swap_count(swap_count), _pass_count(pass_count) { }
 
-  sorted_disks(disk_state&& after, unsigned swap_count)
-    : _after(after), _swap_count(swap_count) { }
+  sorted_disks(disk_state&& after, uint64_t swap_count,
+               uint64_t pass_count = 0)
+    : _after(std::move(after)), _swap_count(swap_count), _pass_count(pass_count) { }
 
   const disk_state& after() const {
     return _after;
   }
 
-  unsigned swap_count() const {
+  uint64_t swap_count() const {
     return _swap_count;
   }
+
+  // Number of passes over the row, counting each direction of a
+  // lawnmower round separately.
+  uint64_t pass_count() const {
+    return _pass_count;
+  }
 };
 
-// Algorithm that sorts disks using the left-to-right algorithm.
-sorted_disks sort_left_to_right(const disk_state& before) {
-  assert(before.is_alternating());
-  unsigned counter = 0;
-  disk_state after = before;
+// Swap and pass counts of a sort done in place, for the *_in_place
+// algorithms that leave the sorted row in the caller's disk_state. A row
+// of n light disks takes n(n-1)/2 swaps, which needs 64 bits once n is
+// past about 92,000.
+struct sort_counts {
+  uint64_t swaps;
+  uint64_t passes;
+};
+
+// Trace sink that ignores every swap. The sorting algorithms take a trace
+// sink as a template parameter and use this one when none is given, so
+// that tracing compiles away entirely when it is off. See swap_trace.hpp
+// for a sink that records the swaps.
+struct null_trace {
+  void record_swap(size_t) { }
+  void end_pass() { }
+};
+
+// Algorithm that sorts disks using the left-to-right algorithm, in place,
+// reporting every swap and the end of every pass to trace.
+template <typename trace_sink>
+sort_counts sort_left_to_right_in_place(disk_state& after, trace_sink& trace) {
+  assert(after.is_alternating());
+  uint64_t counter = 0, passes = 0;
 
-  for(size_t i = 0; i < before.light_count(); i++){
-    for(size_t j = 0; j < before.total_count() - 1; j++){
+  for(size_t i = 0; i < after.light_count(); i++){
+    bool swapped = false;
+    for(size_t j = 0; j < after.total_count() - 1; j++){
       if(after.get(j) == DISK_LIGHT && after.get(j + 1) != DISK_LIGHT){
         after.swap(j);
+        trace.record_swap(j);
         counter++;
+        swapped = true;
       }
     }
+    passes++;
+    trace.end_pass();
+
+    // a pass without any swaps means the row is already sorted
+    if(!swapped){
+      break;
+    }
   }
   
-  return sorted_disks(after, counter);
+  return sort_counts{counter, passes};
+}
+
+sort_counts sort_left_to_right_in_place(disk_state& after) {
+  null_trace trace;
+  return sort_left_to_right_in_place(after, trace);
+}
+
+// Algorithm that sorts disks using the left-to-right algorithm. The
+// rvalue overload sorts the given row itself and moves it into the
+// result, so no copy of the row is made.
+sorted_disks sort_left_to_right(disk_state&& before) {
+  auto counts = sort_left_to_right_in_place(before);
+  return sorted_disks(std::move(before), counts.swaps, counts.passes);
+}
+
+sorted_disks sort_left_to_right(const disk_state& before) {
+  return sort_left_to_right(disk_state(before));
+}
+
+template <typename trace_sink>
+sorted_disks sort_left_to_right(disk_state before, trace_sink& trace) {
+  auto counts = sort_left_to_right_in_place(before, trace);
+  return sorted_disks(std::move(before), counts.swaps, counts.passes);
+}
+
+// Algorithm that sorts disks using the lawnmower algorithm, in place,
+// reporting every swap and the end of every pass to trace.
+//
+// Alternates left-to-right and right-to-left passes. Everything past the
+// last swap of a pass is already in its final place, so each pass narrows
+// the window [left, right] to the last swap position, and the sort stops
+// as soon as a pass makes no swaps.
+template <typename trace_sink>
+sort_counts sort_lawnmower_in_place(disk_state& after, trace_sink& trace) {
+  // check that the input is in alternating format
+  assert(after.is_alternating());
+  uint64_t counter = 0, passes = 0;
+
+  size_t left = 0, right = after.total_count() - 1;
+  while(left < right){
+    // left-to-right: move light disks towards the right end
+    bool swapped = false;
+    size_t last_swap = left;
+    for(size_t j = left; j < right; j++){
+      if(after.get(j) == DISK_LIGHT && after.get(j + 1) == DISK_DARK){
+        after.swap(j);
+        trace.record_swap(j);
+        counter++;
+        swapped = true;
+        last_swap = j;
+      }
+    }
+    passes++;
+    trace.end_pass();
+    if(!swapped){
+      break;
+    }
+    right = last_swap;
+
+    // right-to-left: move dark disks towards the left end
+    swapped = false;
+    last_swap = right;
+    for(size_t j = right; j > left; j--){
+      if(after.get(j - 1) == DISK_LIGHT && after.get(j) == DISK_DARK){
+        after.swap(j - 1);
+        trace.record_swap(j - 1);
+        counter++;
+        swapped = true;
+        last_swap = j;
+      }
+    }
+    passes++;
+    trace.end_pass();
+    if(!swapped){
+      break;
+    }
+    left = last_swap;
+  }
+
+  return sort_counts{counter, passes};
+}
+
+sort_counts sort_lawnmower_in_place(disk_state& after) {
+  null_trace trace;
+  return sort_lawnmower_in_place(after, trace);
 }
 
 // Algorithm that sorts disks using the lawnmower algorithm.
+sorted_disks sort_lawnmower(disk_state&& before) {
+  auto counts = sort_lawnmower_in_place(before);
+  return sorted_disks(std::move(before), counts.swaps, counts.passes);
+}
+
 sorted_disks sort_lawnmower(const disk_state& before) {
-  // TODO: Write code for this function, including rewriting the return
-  // statement, and then delete these comments.
-  // check that the input is in alternating format
-  assert(before.is_alternating());
+  return sort_lawnmower(disk_state(before));
+}
+
+template <typename trace_sink>
+sorted_disks sort_lawnmower(disk_state before, trace_sink& trace) {
+  auto counts = sort_lawnmower_in_place(before, trace);
+  return sorted_disks(std::move(before), counts.swaps, counts.passes);
+}
+
+// Rows shorter than this many disks per thread are not worth splitting
+// further when sort_odd_even_parallel picks its own thread count.
+const size_t PARALLEL_MIN_DISKS_PER_THREAD = 1 << 16;
+
+// Reusable barrier for a fixed group of threads, since C++11 has no
+// std::barrier. Every call to wait() blocks until all threads have
+// reached it, then the barrier resets for the next phase.
+class phase_barrier {
+private:
+  std::mutex _mutex;
+  std::condition_variable _released;
+  const unsigned _count;
+  unsigned _waiting;
+  unsigned _generation;
+
+public:
+
+  explicit phase_barrier(unsigned count)
+    : _count(count), _waiting(0), _generation(0) {
+      assert(count > 0);
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto generation = _generation;
+    if (++_waiting == _count) {
+      _waiting = 0;
+      _generation++;
+      _released.notify_all();
+    } else {
+      _released.wait(lock, [&]() { return generation != _generation; });
+    }
+  }
+};
+
+// Algorithm that sorts disks in place using odd-even transposition, with
+// each phase split across thread_count threads (0 picks one per core,
+// limited by PARALLEL_MIN_DISKS_PER_THREAD).
+//
+// Even phases compare pairs (0,1), (2,3), ... and odd phases compare pairs
+// (1,2), (3,4), ...; the pairs of one phase never overlap, so every thread
+// works on its own chunk and the threads only meet at a barrier between
+// phases. The sort stops after an even and an odd phase in a row make no
+// swaps. Like the other algorithms, every swap fixes exactly one light disk
+// that is left of a dark disk, so the swap count matches theirs.
+sort_counts sort_odd_even_parallel_in_place(disk_state& after,
+                                           unsigned thread_count = 0) {
+  assert(after.is_alternating());
+  const size_t total = after.total_count();
+
+  if (thread_count == 0) {
+    thread_count = unsigned(std::min<size_t>(default_thread_count(),
+        std::max<size_t>(1, total / PARALLEL_MIN_DISKS_PER_THREAD)));
+  }
+  // every thread needs at least one pair of disks
+  thread_count = unsigned(std::min<size_t>(thread_count, after.light_count()));
+
+  // chunk boundaries are even, so an odd-phase pair at the end of one chunk
+  // reaches into the next chunk without overlapping any of its pairs
+  std::vector<size_t> bounds(thread_count + 1);
+  for (unsigned t = 0; t <= thread_count; t++) {
+    bounds[t] = after.light_count() * t / thread_count * 2;
+  }
+
+  // swaps made in each phase, indexed by phase % 4. A slot is read right
+  // after its own phase and the next one, and thread 0 clears it one phase
+  // before it is reused, so no thread can still be reading it.
+  std::atomic<uint64_t> phase_swaps[4];
+  for (auto& slot : phase_swaps) {
+    slot = 0;
+  }
+  std::vector<uint64_t> thread_swaps(thread_count, 0);
+  uint64_t phases = 0;
+  phase_barrier barrier(thread_count);
+
+  auto worker = [&](unsigned t) {
+    const size_t lo = bounds[t], hi = std::min(bounds[t + 1], total - 1);
+    uint64_t counter = 0;
+
+    for (uint64_t phase = 0; ; phase++) {
+      uint64_t swaps = 0;
+      for (size_t j = lo + phase % 2; j < hi; j += 2) {
+        if (after.get(j) == DISK_LIGHT && after.get(j + 1) == DISK_DARK) {
+          after.swap_uncounted(j);
+          swaps++;
+        }
+      }
+      counter += swaps;
+      if (swaps > 0) {
+        phase_swaps[phase % 4] += swaps;
+      }
+      if (t == 0) {
+        phase_swaps[(phase + 1) % 4] = 0;
+      }
+
+      barrier.wait();
+
+      if (phase > 0 &&
+          phase_swaps[phase % 4] == 0 &&
+          phase_swaps[(phase - 1) % 4] == 0) {
+        if (t == 0) {
+          phases = phase + 1;
+        }
+        break;
+      }
+    }
+
+    thread_swaps[t] = counter;
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < thread_count; t++) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  after.recount();
+
+  uint64_t counter = 0;
+  for (auto swaps : thread_swaps) {
+    counter += swaps;
+  }
+
+  return sort_counts{counter, phases};
+}
+
+// Algorithm that sorts disks using parallel odd-even transposition.
+sorted_disks sort_odd_even_parallel(disk_state&& before,
+                                    unsigned thread_count = 0) {
+  auto counts = sort_odd_even_parallel_in_place(before, thread_count);
+  return sorted_disks(std::move(before), counts.swaps, counts.passes);
+}
 
-  // TODO
-  return sorted_disks(before, 0);
+sorted_disks sort_odd_even_parallel(const disk_state& before,
+                                    unsigned thread_count = 0) {
+  return sort_odd_even_parallel(disk_state(before), thread_count);
+}
+
+// Rows with at least this many disks are sorted one at a time by
+// sort_batch, each with sort_odd_even_parallel on every thread.
+const size_t BATCH_SPLIT_DISKS = 2 * PARALLEL_MIN_DISKS_PER_THREAD;
+
+// sort_batch groups smaller rows into tasks of about this much work,
+// counting total_count() squared per row since the sorts are quadratic.
+const size_t BATCH_MIN_TASK_WORK = 1 << 22;
+
+// Sort every row in rows, returning the results in the same order.
+//
+// Small rows are sorted with the left-to-right algorithm, grouped with
+// rows of similar size into tasks for run_work_stealing. Rows of at least
+// BATCH_SPLIT_DISKS disks are split across all threads instead, with
+// sort_odd_even_parallel; their final state and swap count are the same,
+// but pass_count() counts phases. Pass rows with std::move to avoid
+// copying them.
+std::vector<sorted_disks> sort_batch(std::vector<disk_state> rows,
+                                     unsigned thread_count = 0) {
+  if (thread_count == 0) {
+    thread_count = default_thread_count();
+  }
+
+  std::vector<sort_counts> counts(rows.size());
+  std::vector<size_t> small, large;
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (rows[i].total_count() >= BATCH_SPLIT_DISKS) {
+      large.push_back(i);
+    } else {
+      small.push_back(i);
+    }
+  }
+
+  // smallest rows first, so that threads run their largest task first
+  // and other threads steal the small ones
+  std::sort(small.begin(), small.end(), [&](size_t a, size_t b) {
+    return rows[a].total_count() < rows[b].total_count();
+  });
+
+  std::vector<std::function<void()>> tasks;
+  size_t begin = 0, work = 0;
+  for (size_t k = 0; k < small.size(); k++) {
+    size_t disks = rows[small[k]].total_count();
+    work += disks * disks;
+    if (work >= BATCH_MIN_TASK_WORK || k + 1 == small.size()) {
+      size_t end = k + 1;
+      tasks.push_back([&rows, &counts, &small, begin, end]() {
+        for (size_t j = begin; j < end; j++) {
+          counts[small[j]] = sort_left_to_right_in_place(rows[small[j]]);
+        }
+      });
+      begin = end;
+      work = 0;
+    }
+  }
+  run_work_stealing(tasks, thread_count);
+
+  for (auto i : large) {
+    counts[i] = sort_odd_even_parallel_in_place(rows[i], thread_count);
+  }
+
+  std::vector<sorted_disks> results;
+  results.reserve(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    results.emplace_back(std::move(rows[i]), counts[i].swaps, counts[i].passes);
+  }
+  return results;
 }
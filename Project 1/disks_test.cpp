@@ -1,15 +1,22 @@
 ///////////////////////////////////////////////////////////////////////////////
 // disks_test.cpp
 //
-// Unit tests for disks.hpp
+// Unit tests for disks.hpp, disk_io.hpp, mapped_disks.hpp,
+// multi_disks.hpp and swap_trace.hpp
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <cassert>
+#include <cstdio>
+#include <sstream>
 
 #include "rubrictest.hpp"
 
+#include "disk_io.hpp"
 #include "disks.hpp"
+#include "mapped_disks.hpp"
+#include "multi_disks.hpp"
+#include "swap_trace.hpp"
 
 int main() {
 
@@ -69,6 +76,9 @@ int main() {
          auto temp = sorted_disks(alt_three, 3);
          TEST_EQUAL("sorted_disks::after", temp.after(), alt_three);
          TEST_EQUAL("sorted_disks::swap_count", 3, temp.swap_count());
+         // the swap count of a row of 10^8 light disks needs 64 bits
+         const uint64_t large = uint64_t(100000000) * 99999999 / 2;
+         TEST_EQUAL("64-bit swap_count", large, sorted_disks(alt_three, large).swap_count());
 		   });
 
   rubric.criterion("disk_state::is_alternating", 3,
@@ -152,5 +162,304 @@ int main() {
              TEST_EQUAL("n=100 gives 4950 swaps", 4950, trial(100));
            });
 
+  rubric.criterion("early termination, pass counts", 1,
+     		   [&]() {
+             TEST_EQUAL("left-to-right n=1 stops after 1 pass", 1,
+                        sort_left_to_right(disk_state(1)).pass_count());
+             TEST_EQUAL("left-to-right n=10 stops after 10 passes", 10,
+                        sort_left_to_right(disk_state(10)).pass_count());
+             TEST_EQUAL("lawnmower n=1 stops after 1 pass", 1,
+                        sort_lawnmower(disk_state(1)).pass_count());
+             TEST_EQUAL("lawnmower n=3 stops after 2 passes", 2,
+                        sort_lawnmower(disk_state(3)).pass_count());
+             TEST_EQUAL("lawnmower n=100 stops after 100 passes", 100,
+                        sort_lawnmower(disk_state(100)).pass_count());
+           });
+
+  rubric.criterion("parallel odd-even, same result as left-to-right", 1,
+     		   [&]() {
+             for (unsigned threads = 1; threads <= 4; threads++) {
+               for (unsigned n : {1, 2, 3, 4, 10, 57, 100}) {
+                 auto output = sort_odd_even_parallel(disk_state(n), threads);
+                 auto expected = sort_left_to_right(disk_state(n));
+                 TEST_TRUE("actually sorted", output.after().is_sorted());
+                 TEST_EQUAL("same final state", expected.after(), output.after());
+                 TEST_EQUAL("same number of swaps",
+                            expected.swap_count(), output.swap_count());
+               }
+             }
+             TEST_EQUAL("n=100 default threads gives 4950 swaps", 4950,
+                        sort_odd_even_parallel(disk_state(100)).swap_count());
+           });
+
+  rubric.criterion("in-place sorts", 1,
+     		   [&]() {
+             disk_state row(10);
+             auto counts = sort_left_to_right_in_place(row);
+             TEST_TRUE("left-to-right sorted in place", row.is_sorted());
+             TEST_EQUAL("left-to-right n=10 gives 45 swaps", 45, counts.swaps);
+
+             disk_state row2(10);
+             counts = sort_lawnmower_in_place(row2);
+             TEST_TRUE("lawnmower sorted in place", row2.is_sorted());
+             TEST_EQUAL("lawnmower n=10 gives 45 swaps", 45, counts.swaps);
+
+             disk_state row3(10);
+             counts = sort_odd_even_parallel_in_place(row3, 2);
+             TEST_TRUE("odd-even sorted in place", row3.is_sorted());
+             TEST_EQUAL("odd-even n=10 gives 45 swaps", 45, counts.swaps);
+
+             const disk_state before(10);
+             auto output = sort_lawnmower(before);
+             TEST_TRUE("const input left alone", before.is_alternating());
+             TEST_TRUE("copy sorted", output.after().is_sorted());
+           });
+
+  rubric.criterion("file-backed rows", 1,
+     		   [&]() {
+             const std::string path = "disks_test_row.bin";
+
+             for (unsigned n : {1, 2, 3, 10, 31, 32, 33, 100}) {
+               auto row = mapped_disk_state::create(path, n);
+               TEST_TRUE("created alternating", row.is_alternating());
+               auto counts = sort_left_to_right_mapped(row);
+               auto expected = sort_left_to_right(disk_state(n));
+               TEST_TRUE("actually sorted", row.is_sorted());
+               TEST_EQUAL("same number of swaps", expected.swap_count(), counts.swaps);
+               for (size_t i = 0; i < row.total_count(); i++) {
+                 TEST_EQUAL("same final state", expected.after().get(i), row.get(i));
+               }
+             }
+
+             {
+               auto row = mapped_disk_state::create(path, 40);
+               row.step();
+               row.step();
+               row.step();
+             }
+             auto resumed = mapped_disk_state::open(path);
+             TEST_EQUAL("resumes after 3 passes", 3, resumed.pass_count());
+             auto counts = sort_left_to_right_mapped(resumed);
+             TEST_TRUE("resumed sort finishes", resumed.is_sorted());
+             TEST_EQUAL("n=40 gives 780 swaps", 780, counts.swaps);
+
+             // both copies start on a page boundary of this system
+             struct stat st;
+             TEST_TRUE("stat row file", ::stat(path.c_str(), &st) == 0);
+             TEST_EQUAL("whole pages", 0, size_t(st.st_size) % size_t(::sysconf(_SC_PAGESIZE)));
+
+             std::remove(path.c_str());
+           });
+
+  rubric.criterion("swap traces", 1,
+     		   [&]() {
+             swap_trace trace;
+             auto output = sort_lawnmower(disk_state(20), trace);
+             TEST_EQUAL("every swap recorded", output.swap_count(), trace.swap_count());
+             TEST_EQUAL("every pass recorded", output.pass_count(), trace.pass_count());
+             TEST_LT("about one byte per swap",
+                     trace.byte_count(), 2 * trace.swap_count());
+             TEST_EQUAL("full replay gives the sorted row",
+                        output.after(), replay(disk_state(20), trace, trace.swap_count()));
+
+             disk_state step_by_step(20);
+             swap_trace first_pass;
+             step_by_step.swap(1);
+             first_pass.record_swap(1);
+             step_by_step.swap(0);
+             first_pass.record_swap(0);
+             first_pass.end_pass();
+             TEST_EQUAL("replay one pass", step_by_step,
+                        replay_passes(disk_state(20), first_pass, 1));
+
+             std::stringstream buffer;
+             trace.write(buffer);
+             auto loaded = swap_trace::read(buffer);
+             TEST_EQUAL("loaded swap count", trace.swap_count(), loaded.swap_count());
+             TEST_EQUAL("loaded pass count", trace.pass_count(), loaded.pass_count());
+             TEST_EQUAL("loaded trace replays the same",
+                        replay_passes(disk_state(20), trace, 5),
+                        replay_passes(disk_state(20), loaded, 5));
+
+             // headers claiming more bytes than the stream holds
+             const std::string saved = buffer.str();
+             for (uint64_t length : {uint64_t(1) << 62, uint64_t(1) << 44,
+                                     uint64_t(saved.size())}) {
+               std::string corrupt = saved;
+               for (int i = 0; i < 8; ++i) {
+                 corrupt[8 + i] = char(uint8_t(length >> (8 * i)));
+               }
+               std::stringstream in(corrupt);
+               bool threw = false;
+               try {
+                 swap_trace::read(in);
+               } catch (std::runtime_error&) {
+                 threw = true;
+               }
+               TEST_TRUE("oversized trace length rejected", threw);
+             }
+
+             swap_trace left_to_right;
+             sort_left_to_right(disk_state(20), left_to_right);
+             TEST_EQUAL("left-to-right traced", 190, left_to_right.swap_count());
+           });
+
+  rubric.criterion("batch sorting", 1,
+     		   [&]() {
+             std::vector<disk_state> rows;
+             for (unsigned n = 1; n <= 60; n++) {
+               rows.push_back(disk_state(61 - n));
+             }
+             for (unsigned threads : {1, 4}) {
+               auto results = sort_batch(rows, threads);
+               TEST_EQUAL("one result per row", rows.size(), results.size());
+               for (size_t i = 0; i < rows.size(); i++) {
+                 auto expected = sort_left_to_right(rows[i]);
+                 TEST_EQUAL("results in input order",
+                            rows[i].total_count(), results[i].after().total_count());
+                 TEST_TRUE("actually sorted", results[i].after().is_sorted());
+                 TEST_EQUAL("same number of swaps",
+                            expected.swap_count(), results[i].swap_count());
+               }
+             }
+             TEST_TRUE("empty batch", sort_batch(std::vector<disk_state>()).empty());
+           });
+
+  rubric.criterion("disk_state counters", 1,
+     		   [&]() {
+             TEST_EQUAL("n=3 starts with 3 inversions", 3, alt_three.inversion_count());
+             TEST_EQUAL("n=3 starts with 1 light disk on the left",
+                        1, alt_three.left_light_count());
+             TEST_EQUAL("n=3 starts alternating", 0, alt_three.misplaced_count());
+             TEST_EQUAL("n=3 sorted has no inversions", 0, sorted_three.inversion_count());
+             TEST_EQUAL("n=3 sorted has 2 misplaced disks",
+                        2, sorted_three.misplaced_count());
+
+             disk_state row(7);
+             row.swap(5);
+             TEST_EQUAL("one swap removes one inversion", 20, row.inversion_count());
+             row.swap(5);
+             TEST_EQUAL("swapping back restores it", 21, row.inversion_count());
+             TEST_TRUE("and is alternating again", row.is_alternating());
+             row.swap(6);
+             TEST_EQUAL("swap across the middle", 4, row.left_light_count());
+
+             disk_state recounted = row;
+             recounted.recount();
+             TEST_EQUAL("recount agrees on inversions",
+                        row.inversion_count(), recounted.inversion_count());
+             TEST_EQUAL("recount agrees on left light disks",
+                        row.left_light_count(), recounted.left_light_count());
+             TEST_EQUAL("recount agrees on misplaced disks",
+                        row.misplaced_count(), recounted.misplaced_count());
+
+             auto output = sort_odd_even_parallel(disk_state(50), 3);
+             TEST_EQUAL("parallel sort recounts", 0, output.after().inversion_count());
+           });
+
+  rubric.criterion("multi-color counting sort", 1,
+     		   [&]() {
+             for (unsigned n : {1, 10, 100}) {
+               auto output = sort_counting(multi_disk_state::alternating(2, n));
+               TEST_TRUE("two colors sorted", output.after().is_sorted());
+               TEST_EQUAL("two colors, same swaps as left-to-right",
+                          sort_left_to_right(disk_state(n)).swap_count(),
+                          output.swap_count());
+             }
+
+             // compare with bubble sort on a pseudorandom row
+             std::vector<multi_color> colors;
+             unsigned x = 12345;
+             for (unsigned i = 0; i < 300; i++) {
+               x = x * 1103515245 + 12345;
+               colors.push_back(multi_color((x >> 16) % 7));
+             }
+             multi_disk_state row(7, colors);
+             multi_disk_state bubbled = row;
+             uint64_t bubble_swaps = 0;
+             for (size_t pass = 0; pass < bubbled.total_count(); pass++) {
+               for (size_t j = 0; j + 1 < bubbled.total_count(); j++) {
+                 if (bubbled.get(j) > bubbled.get(j + 1)) {
+                   bubbled.swap(j);
+                   bubble_swaps++;
+                 }
+               }
+             }
+             for (unsigned threads : {1, 3}) {
+               auto output = sort_counting(row, threads);
+               TEST_EQUAL("seven colors, same row as bubble sort", bubbled, output.after());
+               TEST_EQUAL("seven colors, same swaps as bubble sort",
+                          bubble_swaps, output.swap_count());
+             }
+             // every pair of the 10 repeats has 256 * 255 / 2 inversions
+             TEST_EQUAL("256 colors, repeating pattern",
+                        uint64_t(10) * 9 / 2 * (256 * 255 / 2),
+                        count_adjacent_swaps(multi_disk_state::alternating(256, 10)));
+           });
+
+  rubric.criterion("saving and loading rows", 1,
+     		   [&]() {
+             TEST_EQUAL("to_string for n=3", "D L D L D L", alt_three.to_string());
+             TEST_EQUAL("to_string after swaps", "D D D L L L", sorted_three.to_string());
+             TEST_EQUAL("parse to_string", sorted_three,
+                        disk_state_from_string(sorted_three.to_string()));
+             TEST_EQUAL("parse without spaces", sorted_three,
+                        disk_state_from_string("DDDLLL\n"));
+
+             for (unsigned n : {1, 3, 31, 32, 33, 1000}) {
+               auto row = sort_lawnmower(disk_state(n)).after();
+               row.swap(n - 1);
+
+               std::stringstream binary;
+               write_binary(binary, row);
+               TEST_EQUAL("binary is one bit per disk",
+                          16 + (row.total_count() + 63) / 64 * 8, binary.str().size());
+               auto loaded = read_binary(binary);
+               TEST_EQUAL("binary round trip", row, loaded);
+               TEST_EQUAL("binary round trip keeps counters",
+                          row.inversion_count(), loaded.inversion_count());
+
+               std::stringstream text;
+               write_text(text, row);
+               TEST_EQUAL("text matches to_string", row.to_string() + "\n", text.str());
+               TEST_EQUAL("text round trip", row, read_text(text));
+             }
+
+             bool threw = false;
+             try {
+               disk_state_from_string("D L L");
+             } catch (std::runtime_error&) {
+               threw = true;
+             }
+             TEST_TRUE("unbalanced row rejected", threw);
+
+             // headers claiming more disks than the stream holds
+             std::stringstream good;
+             write_binary(good, disk_state(1000));
+             const std::string bytes = good.str();
+             for (uint64_t total : {uint64_t(1) << 62, uint64_t(1) << 44, uint64_t(4000)}) {
+               std::string corrupt = bytes;
+               uint8_t count[8];
+               disk_io_detail::put_u64(count, total);
+               corrupt.replace(8, 8, reinterpret_cast<const char*>(count), 8);
+               std::stringstream in(corrupt);
+               threw = false;
+               try {
+                 read_binary(in);
+               } catch (std::runtime_error&) {
+                 threw = true;
+               }
+               TEST_TRUE("oversized count rejected", threw);
+             }
+             std::stringstream truncated(bytes.substr(0, bytes.size() - 8));
+             threw = false;
+             try {
+               read_binary(truncated);
+             } catch (std::runtime_error&) {
+               threw = true;
+             }
+             TEST_TRUE("truncated row rejected", threw);
+           });
+
   return rubric.run();
 }
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+// disks_timing.cpp
+//
+// Scaling sweeps for the disks sorting algorithms. For every algorithm,
+// n (the number of light disks) runs over several orders of magnitude,
+// each run is repeated and the median time kept, and one CSV row is
+// printed per (n, algorithm):
+//
+//    n,algorithm,swaps,seconds,ns_per_disk
+//
+// Afterwards a least-squares fit of log(seconds) against log(n) is
+// printed to stderr for each algorithm. All of these algorithms are
+// quadratic, so an exponent above max_exponent is reported as a
+// regression and the program exits with status 1.
+//
+// Usage:
+//
+//    ./disks_timing [max_n [repeats [max_exponent]]] > disks.csv
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "timer.hpp"
+
+#include "disks.hpp"
+
+// Runs below this many seconds are mostly timer noise, and are left out
+// of the fit.
+const double MIN_FIT_SECONDS = 1e-4;
+
+struct algorithm {
+  std::string name;
+  std::function<sorted_disks(const disk_state&)> sort;
+};
+
+// Slope of the least-squares line through the points (log x, log y).
+double fit_exponent(const std::vector<double>& x, const std::vector<double>& y) {
+  assert(x.size() == y.size());
+  const double k = x.size();
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    double lx = std::log(x[i]), ly = std::log(y[i]);
+    sx += lx;
+    sy += ly;
+    sxx += lx * lx;
+    sxy += lx * ly;
+  }
+  return (k * sxy - sx * sy) / (k * sxx - sx * sx);
+}
+
+int main(int argc, char* argv[]) {
+
+  const size_t max_n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  const unsigned repeats = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 3;
+  const double max_exponent = (argc > 3) ? std::strtod(argv[3], nullptr) : 2.5;
+
+  assert(max_n > 0);
+  assert(repeats > 0);
+
+  // 1-2-5 steps give a few points per decade
+  std::vector<size_t> sizes;
+  for (size_t decade = 1; decade <= max_n; decade *= 10) {
+    for (size_t step : {1, 2, 5}) {
+      if (decade * step <= max_n) {
+        sizes.push_back(decade * step);
+      }
+    }
+  }
+
+  const std::vector<algorithm> algorithms{
+    {"left-to-right", [](const disk_state& d) { return sort_left_to_right(d); }},
+    {"lawnmower", [](const disk_state& d) { return sort_lawnmower(d); }},
+    {"odd-even-parallel", [](const disk_state& d) { return sort_odd_even_parallel(d); }},
+  };
+
+  std::cout << "n,algorithm,swaps,seconds,ns_per_disk" << std::endl;
+
+  bool regression = false;
+
+  for (auto& alg : algorithms) {
+    std::vector<double> fit_n, fit_seconds;
+
+    for (auto n : sizes) {
+      const disk_state input(n);
+      std::vector<double> times;
+      uint64_t swaps = 0;
+
+      for (unsigned r = 0; r < repeats; ++r) {
+        Timer timer;
+        auto output = alg.sort(input);
+        times.push_back(timer.elapsed());
+        assert(output.after().is_sorted());
+        swaps = output.swap_count();
+      }
+
+      std::sort(times.begin(), times.end());
+      double seconds = times[times.size() / 2];
+
+      std::cout << n << ","
+                << alg.name << ","
+                << swaps << ","
+                << seconds << ","
+                << seconds * 1e9 / input.total_count() << std::endl;
+
+      if (seconds >= MIN_FIT_SECONDS) {
+        fit_n.push_back(n);
+        fit_seconds.push_back(seconds);
+      }
+    }
+
+    if (fit_n.size() < 2) {
+      std::cerr << alg.name << ": too few timed points to fit" << std::endl;
+      continue;
+    }
+
+    double exponent = fit_exponent(fit_n, fit_seconds);
+    std::cerr << alg.name << ": time ~ n^" << exponent << std::endl;
+    if (exponent > max_exponent) {
+      std::cerr << alg.name << ": exponent exceeds " << max_exponent
+                << ", possible regression" << std::endl;
+      regression = true;
+    }
+  }
+
+  return regression ? 1 : 0;
+}
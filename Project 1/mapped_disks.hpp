@@ -0,0 +1,357 @@
+///////////////////////////////////////////////////////////////////////////////
+// mapped_disks.hpp
+//
+// File-backed row of disks, for rows too large to keep in memory as a
+// disk_state.
+//
+// The row is bit-packed (bit i of word w is disk 64w+i, set for a light
+// disk) and the file holds two copies of it. A left-to-right pass streams
+// the current copy into the other one, syncs it to disk, and only then
+// rewrites the header to point at the new copy. The copy named by the
+// header is never written to, so after a crash the sort resumes from the
+// last completed pass by opening the same file again.
+//
+// This header depends on POSIX mmap, so unlike disks.hpp it is not
+// portable to Windows.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "disks.hpp"
+
+class mapped_disk_state {
+private:
+  // On-disk header, written in one piece with pwrite so that it is
+  // either entirely old or entirely new after a crash.
+  struct header {
+    char magic[8];
+    uint64_t light_count;
+    uint64_t current;   // which copy of the row is valid, 0 or 1
+    uint64_t passes;
+    uint64_t swaps;
+    uint64_t finished;
+    // page size the file was laid out for
+    uint64_t page_bytes;
+  };
+
+  static const char* magic() {
+    return "DISKROW2";
+  }
+
+  // The file is a header page, then each copy of the row rounded up to
+  // whole pages, so that both copies can be msync'ed and madvise'd on
+  // their own. The page size is the system's when the file is created,
+  // and is recorded in the header since msync needs page-aligned
+  // addresses.
+  static size_t system_page_bytes() {
+    long bytes = ::sysconf(_SC_PAGESIZE);
+    if (bytes <= 0) {
+      fail("page size");
+    }
+    return size_t(bytes);
+  }
+
+  int _fd;
+  uint8_t* _base;
+  size_t _file_bytes;
+  size_t _region_bytes;
+  header _header;
+
+  static size_t word_count(uint64_t light_count) {
+    return (light_count * 2 + 63) / 64;
+  }
+
+  static size_t region_bytes(uint64_t light_count, size_t page_bytes) {
+    size_t bytes = word_count(light_count) * sizeof(uint64_t);
+    return (bytes + page_bytes - 1) / page_bytes * page_bytes;
+  }
+
+  static size_t file_bytes(uint64_t light_count, size_t page_bytes) {
+    return page_bytes + 2 * region_bytes(light_count, page_bytes);
+  }
+
+  [[noreturn]] static void fail(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  mapped_disk_state()
+    : _fd(-1), _base(nullptr), _file_bytes(0), _region_bytes(0) {
+      std::memset(&_header, 0, sizeof(_header));
+  }
+
+  void map(const std::string& path) {
+    _region_bytes = region_bytes(_header.light_count, _header.page_bytes);
+    _file_bytes = file_bytes(_header.light_count, _header.page_bytes);
+    void* base = ::mmap(nullptr, _file_bytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, _fd, 0);
+    if (base == MAP_FAILED) {
+      fail("mmap " + path);
+    }
+    _base = static_cast<uint8_t*>(base);
+  }
+
+  uint64_t* region(uint64_t which) const {
+    return reinterpret_cast<uint64_t*>(_base + _header.page_bytes + which * _region_bytes);
+  }
+
+  const uint64_t* words() const {
+    return region(_header.current);
+  }
+
+  // Mask of the bits of word w that hold disks; the tail of the last
+  // word is padding and always zero.
+  uint64_t valid_mask(size_t w) const {
+    size_t used = total_count() - w * 64;
+    return (used >= 64) ? ~uint64_t(0) : ((uint64_t(1) << used) - 1);
+  }
+
+  void write_header() {
+    if (::pwrite(_fd, &_header, sizeof(_header), 0) != ssize_t(sizeof(_header))) {
+      fail("write header");
+    }
+    if (::fdatasync(_fd) != 0) {
+      fail("sync header");
+    }
+  }
+
+  void release() {
+    if (_base != nullptr) {
+      ::munmap(_base, _file_bytes);
+      _base = nullptr;
+    }
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+
+public:
+
+  // Create (or overwrite) the file at path with an alternating row of
+  // light_count light and light_count dark disks.
+  static mapped_disk_state create(const std::string& path, size_t light_count) {
+    assert(light_count > 0);
+
+    mapped_disk_state result;
+    result._fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (result._fd < 0) {
+      fail("create " + path);
+    }
+
+    std::memcpy(result._header.magic, magic(), sizeof(result._header.magic));
+    result._header.light_count = light_count;
+    result._header.page_bytes = system_page_bytes();
+
+    if (::ftruncate(result._fd, file_bytes(light_count, result._header.page_bytes)) != 0) {
+      fail("resize " + path);
+    }
+    result.map(path);
+
+    // dark disks at even indices, light disks at odd indices
+    uint64_t* row = result.region(0);
+    for (size_t w = 0; w < word_count(light_count); ++w) {
+      row[w] = UINT64_C(0xAAAAAAAAAAAAAAAA) & result.valid_mask(w);
+    }
+    if (::msync(row, result._region_bytes, MS_SYNC) != 0) {
+      fail("sync " + path);
+    }
+    result.write_header();
+
+    return result;
+  }
+
+  // Open a file made by create(), possibly part way through a sort.
+  static mapped_disk_state open(const std::string& path) {
+    mapped_disk_state result;
+    result._fd = ::open(path.c_str(), O_RDWR);
+    if (result._fd < 0) {
+      fail("open " + path);
+    }
+
+    if (::pread(result._fd, &result._header, sizeof(result._header), 0)
+        != ssize_t(sizeof(result._header))) {
+      fail("read header of " + path);
+    }
+    if (std::memcmp(result._header.magic, magic(), sizeof(result._header.magic)) != 0
+        || result._header.light_count == 0
+        || result._header.current > 1
+        || result._header.page_bytes == 0) {
+      errno = EINVAL;
+      fail(path + " is not a disk row file");
+    }
+    // a file laid out for smaller pages than this system's has copies
+    // that do not start on a page boundary
+    if (result._header.page_bytes % system_page_bytes() != 0) {
+      errno = EINVAL;
+      fail(path + " was created for a smaller page size");
+    }
+
+    struct stat st;
+    if (::fstat(result._fd, &st) != 0) {
+      fail("stat " + path);
+    }
+    if (uint64_t(st.st_size) != file_bytes(result._header.light_count,
+                                           result._header.page_bytes)) {
+      errno = EINVAL;
+      fail(path + " has the wrong size");
+    }
+
+    result.map(path);
+    return result;
+  }
+
+  mapped_disk_state(mapped_disk_state&& other)
+    : _fd(other._fd), _base(other._base), _file_bytes(other._file_bytes),
+      _region_bytes(other._region_bytes), _header(other._header) {
+      other._fd = -1;
+      other._base = nullptr;
+  }
+
+  mapped_disk_state(const mapped_disk_state&) = delete;
+  mapped_disk_state& operator= (const mapped_disk_state&) = delete;
+
+  ~mapped_disk_state() {
+    release();
+  }
+
+  size_t total_count() const {
+    return _header.light_count * 2;
+  }
+
+  size_t light_count() const {
+    return _header.light_count;
+  }
+
+  size_t dark_count() const {
+    return light_count();
+  }
+
+  bool is_index(size_t i) const {
+    return (i < total_count());
+  }
+
+  disk_color get(size_t index) const {
+    assert(is_index(index));
+    return ((words()[index / 64] >> (index % 64)) & 1) ? DISK_LIGHT : DISK_DARK;
+  }
+
+  // Passes and swaps completed as of the last checkpoint.
+  uint64_t pass_count() const {
+    return _header.passes;
+  }
+
+  uint64_t swap_count() const {
+    return _header.swaps;
+  }
+
+  // True once a pass has made no swaps.
+  bool is_finished() const {
+    return _header.finished != 0;
+  }
+
+  bool is_alternating() const {
+    for (size_t w = 0; w < word_count(light_count()); ++w) {
+      if ((words()[w] & UINT64_C(0xAAAAAAAAAAAAAAAA) & valid_mask(w))
+          != (UINT64_C(0xAAAAAAAAAAAAAAAA) & valid_mask(w))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // All dark disks are on the left when the first half holds no light
+  // disk, since the row has as many light disks as dark ones.
+  bool is_sorted() const {
+    const size_t half = light_count();
+    for (size_t w = 0; w * 64 < half; ++w) {
+      size_t used = half - w * 64;
+      uint64_t mask = (used >= 64) ? ~uint64_t(0) : ((uint64_t(1) << used) - 1);
+      if (words()[w] & mask) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Run one left-to-right pass and checkpoint it, returning the number of
+  // swaps it made.
+  //
+  // In a left-to-right pass every dark disk that has some light disk to
+  // its left moves exactly one place left, and all other disks stay put,
+  // so a pass is a shift of those dark disks by one bit and its swap count
+  // is their number.
+  uint64_t step() {
+    assert(!is_finished());
+
+    const size_t count = word_count(light_count());
+    const uint64_t* src = words();
+    uint64_t* dst = region(1 - _header.current);
+
+    ::madvise(const_cast<uint64_t*>(src), _region_bytes, MADV_SEQUENTIAL);
+    ::madvise(dst, _region_bytes, MADV_SEQUENTIAL);
+
+    bool seen_light = false;
+    uint64_t swaps = 0;
+    for (size_t w = 0; w < count; ++w) {
+      const uint64_t x = src[w], valid = valid_mask(w);
+      const uint64_t dark = ~x & valid;
+
+      // bits above the lowest light disk of this word, or every bit once
+      // a light disk was seen in an earlier word
+      const uint64_t lowest = x & (~x + 1);
+      const uint64_t after_light = seen_light ? ~uint64_t(0) : ~(lowest | (lowest - 1));
+      seen_light = seen_light || (x != 0);
+
+      const uint64_t moving = dark & after_light;
+
+      // the first disk of the next word moves into our last bit when it
+      // is a dark disk with a light disk somewhere before it
+      uint64_t incoming = 0;
+      if (w + 1 < count && seen_light && (~src[w + 1] & valid_mask(w + 1) & 1)) {
+        incoming = uint64_t(1) << 63;
+      }
+
+      const uint64_t new_dark = (dark & ~moving) | (moving >> 1) | incoming;
+      dst[w] = ~new_dark & valid;
+      swaps += __builtin_popcountll(moving);
+    }
+
+    _header.passes++;
+    if (swaps == 0) {
+      // nothing moved, so the current copy stays valid as it is
+      _header.finished = 1;
+    } else {
+      if (::msync(dst, _region_bytes, MS_SYNC) != 0) {
+        fail("sync row");
+      }
+      _header.current = 1 - _header.current;
+      _header.swaps += swaps;
+    }
+    write_header();
+
+    return swaps;
+  }
+};
+
+// Algorithm that sorts a file-backed row using the left-to-right algorithm,
+// checkpointing after every pass. A row opened part way through a sort
+// picks up from its last checkpoint; the counts cover the whole sort.
+sort_counts sort_left_to_right_mapped(mapped_disk_state& disks) {
+  while (!disks.is_finished()) {
+    disks.step();
+  }
+  return sort_counts{disks.swap_count(), disks.pass_count()};
+}
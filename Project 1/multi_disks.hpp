@@ -0,0 +1,250 @@
+///////////////////////////////////////////////////////////////////////////////
+// multi_disks.hpp
+//
+// Rows of disks in up to 256 colors, sorted by counting instead of by
+// adjacent swaps.
+//
+// Sorted means every disk of color c is left of every disk of color c+1,
+// the same order as disk_state with DISK_DARK = 0 and DISK_LIGHT = 1.
+// Sorting by adjacent swaps takes exactly as many swaps as there are
+// inversions (pairs with the larger color on the left), so that count is
+// computed directly, with a Fenwick tree over the colors, in
+// O(n log k) time split across threads.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "work_stealing.hpp"
+
+// Color of one disk, from 0 to color_count - 1.
+using multi_color = uint8_t;
+
+// Rows shorter than this many disks per thread are not worth splitting
+// further when counting inversions or sorting.
+const size_t MULTI_MIN_DISKS_PER_THREAD = 1 << 16;
+
+// Data structure for the state of one row of disks in color_count colors.
+class multi_disk_state {
+private:
+  std::vector<multi_color> _colors;
+  unsigned _color_count;
+
+public:
+
+  multi_disk_state(unsigned color_count, std::vector<multi_color> colors)
+    : _colors(std::move(colors)), _color_count(color_count) {
+
+      assert(color_count >= 1 && color_count <= 256);
+      assert(std::all_of(_colors.begin(), _colors.end(),
+                         [&](multi_color c) { return c < color_count; }));
+  }
+
+  // A row of per_color disks of each color, in the repeating pattern
+  // 0, 1, ..., color_count - 1, 0, 1, ...; for two colors this is the
+  // alternating format of disk_state.
+  static multi_disk_state alternating(unsigned color_count, size_t per_color) {
+    std::vector<multi_color> colors(color_count * per_color);
+    for (size_t i = 0; i < colors.size(); i++) {
+      colors[i] = multi_color(i % color_count);
+    }
+    return multi_disk_state(color_count, std::move(colors));
+  }
+
+  // Equality operator for unit tests.
+  bool operator== (const multi_disk_state& rhs) const {
+    return _color_count == rhs._color_count && _colors == rhs._colors;
+  }
+
+  size_t total_count() const {
+    return _colors.size();
+  }
+
+  unsigned color_count() const {
+    return _color_count;
+  }
+
+  bool is_index(size_t i) const {
+    return (i < total_count());
+  }
+
+  multi_color get(size_t index) const {
+    assert(is_index(index));
+    return _colors[index];
+  }
+
+  void swap(size_t left_index) {
+    assert(is_index(left_index));
+    assert(is_index(left_index + 1));
+    std::swap(_colors[left_index], _colors[left_index + 1]);
+  }
+
+  const std::vector<multi_color>& colors() const {
+    return _colors;
+  }
+
+  std::string to_string() const {
+    std::stringstream ss;
+    bool first = true;
+    for (auto color : _colors) {
+      if (!first) {
+        ss << " ";
+      }
+      ss << unsigned(color);
+      first = false;
+    }
+    return ss.str();
+  }
+
+  // Return true when the colors are in non-decreasing order.
+  bool is_sorted() const {
+    return std::is_sorted(_colors.begin(), _colors.end());
+  }
+};
+
+// Data structure for the output of sort_counting: the final
+// multi_disk_state, and the number of adjacent swaps a swap-based sort
+// would have needed to reach it.
+class sorted_multi_disks {
+private:
+  multi_disk_state _after;
+  uint64_t _swap_count;
+
+public:
+
+  sorted_multi_disks(multi_disk_state&& after, uint64_t swap_count)
+    : _after(std::move(after)), _swap_count(swap_count) { }
+
+  const multi_disk_state& after() const {
+    return _after;
+  }
+
+  uint64_t swap_count() const {
+    return _swap_count;
+  }
+};
+
+namespace multi_disks_detail {
+
+// Number of chunks to split a row of total disks into, one per thread
+// (0 for one per core) but none shorter than MULTI_MIN_DISKS_PER_THREAD.
+inline size_t chunk_count(size_t total, unsigned thread_count) {
+  if (thread_count == 0) {
+    thread_count = default_thread_count();
+  }
+  return std::max<size_t>(1, std::min<size_t>(thread_count,
+                                              total / MULTI_MIN_DISKS_PER_THREAD));
+}
+
+// Split [0, total) into chunks equal parts, and run chunk_task(t, lo, hi)
+// for each chunk t on the work-stealing threads.
+inline void for_each_chunk(size_t total, size_t chunks,
+                           std::function<void(size_t, size_t, size_t)> chunk_task) {
+  std::vector<std::function<void()>> tasks;
+  for (size_t t = 0; t < chunks; t++) {
+    size_t lo = total * t / chunks, hi = total * (t + 1) / chunks;
+    tasks.push_back([=]() { chunk_task(t, lo, hi); });
+  }
+  run_work_stealing(tasks, unsigned(chunks));
+}
+
+} // namespace multi_disks_detail
+
+// Number of adjacent swaps needed to sort disks, which is the number of
+// pairs i < j with disks.get(i) > disks.get(j).
+//
+// Each chunk of the row counts its own inversions with a Fenwick tree and
+// keeps a histogram of its colors; an inversion between two chunks pairs
+// a disk in the later chunk with a larger color from an earlier chunk, so
+// those are summed from the histograms afterwards.
+uint64_t count_adjacent_swaps(const multi_disk_state& disks,
+                              unsigned thread_count = 0) {
+  const unsigned k = disks.color_count();
+  const auto& colors = disks.colors();
+
+  const size_t chunks = multi_disks_detail::chunk_count(colors.size(), thread_count);
+  std::vector<uint64_t> inside(chunks, 0);
+  std::vector<std::vector<uint64_t>> histograms(chunks, std::vector<uint64_t>(k, 0));
+
+  multi_disks_detail::for_each_chunk(colors.size(), chunks,
+      [&](size_t t, size_t lo, size_t hi) {
+        // fenwick[c] covers colors (c - (c & -c), c], one-based
+        std::vector<uint64_t> fenwick(k + 1, 0);
+        auto& histogram = histograms[t];
+        uint64_t inversions = 0;
+        for (size_t i = lo; i < hi; i++) {
+          unsigned c = colors[i];
+          // disks seen so far with a color of at most c
+          uint64_t not_greater = 0;
+          for (unsigned j = c + 1; j > 0; j -= j & (~j + 1)) {
+            not_greater += fenwick[j];
+          }
+          inversions += (i - lo) - not_greater;
+          for (unsigned j = c + 1; j <= k; j += j & (~j + 1)) {
+            fenwick[j]++;
+          }
+          histogram[c]++;
+        }
+        inside[t] = inversions;
+      });
+
+  uint64_t total = 0;
+  // disks of each color in the chunks before the current one
+  std::vector<uint64_t> before(k, 0);
+  for (size_t t = 0; t < chunks; t++) {
+    total += inside[t];
+    uint64_t greater_before = 0;
+    for (unsigned c = k; c-- > 0; ) {
+      total += histograms[t][c] * greater_before;
+      greater_before += before[c];
+    }
+    for (unsigned c = 0; c < k; c++) {
+      before[c] += histograms[t][c];
+    }
+  }
+  return total;
+}
+
+// Algorithm that sorts disks by counting the disks of each color and
+// rewriting the row, in linear time. The swap count is that of any sort
+// by adjacent swaps, from count_adjacent_swaps.
+sorted_multi_disks sort_counting(const multi_disk_state& before,
+                                 unsigned thread_count = 0) {
+  const unsigned k = before.color_count();
+  uint64_t swaps = count_adjacent_swaps(before, thread_count);
+
+  // first index of each color in the sorted row
+  std::vector<size_t> starts(k + 1, 0);
+  for (auto c : before.colors()) {
+    starts[c + 1]++;
+  }
+  for (unsigned c = 0; c < k; c++) {
+    starts[c + 1] += starts[c];
+  }
+
+  std::vector<multi_color> colors(before.total_count());
+  multi_disks_detail::for_each_chunk(colors.size(),
+      multi_disks_detail::chunk_count(colors.size(), thread_count),
+      [&](size_t, size_t lo, size_t hi) {
+        // the first color whose run reaches past lo
+        unsigned c = unsigned(std::upper_bound(starts.begin(), starts.end(), lo)
+                              - starts.begin()) - 1;
+        for (size_t i = lo; i < hi; c++) {
+          size_t end = std::min(hi, starts[c + 1]);
+          std::fill(colors.begin() + i, colors.begin() + end, multi_color(c));
+          i = end;
+        }
+      });
+
+  return sorted_multi_disks(multi_disk_state(k, std::move(colors)), swaps);
+}
@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+// swap_trace.hpp
+//
+// Compact record of the swaps made by a disks sorting algorithm, and
+// replay of a record to rebuild any intermediate disk_state.
+//
+// How to use:
+//
+//    swap_trace trace;
+//    auto output = sort_lawnmower(disk_state(n), trace);
+//    // state of the row after the first 3 passes
+//    disk_state middle = replay_passes(disk_state(n), trace, 3);
+//
+// Each swap is stored as the distance from the previous swap's index,
+// zigzag encoded so backwards steps stay small, plus one, as a base-128
+// varint; a zero byte marks the end of a pass. Consecutive swaps in a pass
+// are usually two disks apart, so most swaps take a single byte.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+#include "disks.hpp"
+
+class swap_trace {
+private:
+  std::vector<uint8_t> _bytes;
+  // total number of swaps at the end of each pass
+  std::vector<size_t> _pass_ends;
+  size_t _swap_count;
+  size_t _last_index;
+
+  static const char* magic() {
+    return "SWPTRAC1";
+  }
+
+  void put_varint(uint64_t value) {
+    while (value >= 0x80) {
+      _bytes.push_back(uint8_t(value) | 0x80);
+      value >>= 7;
+    }
+    _bytes.push_back(uint8_t(value));
+  }
+
+  // Decode the varint starting at bytes[pos] and move pos past it.
+  static uint64_t get_varint(const std::vector<uint8_t>& bytes, size_t& pos) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+      if (pos >= bytes.size() || shift > 63) {
+        throw std::runtime_error("corrupt swap trace");
+      }
+      byte = bytes[pos++];
+      value |= uint64_t(byte & 0x7F) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    return value;
+  }
+
+  // Index of the swap encoded as value, which follows a swap at index.
+  static size_t next_index(size_t index, uint64_t value) {
+    uint64_t zigzag = value - 1;
+    int64_t delta = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+    return size_t(int64_t(index) + delta);
+  }
+
+public:
+
+  swap_trace()
+    : _swap_count(0), _last_index(0) { }
+
+  // Trace sink interface, called by the sorting algorithms.
+  void record_swap(size_t index) {
+    int64_t delta = int64_t(index) - int64_t(_last_index);
+    uint64_t zigzag = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+    put_varint(zigzag + 1);
+    _last_index = index;
+    _swap_count++;
+  }
+
+  void end_pass() {
+    _bytes.push_back(0);
+    _pass_ends.push_back(_swap_count);
+  }
+
+  size_t swap_count() const {
+    return _swap_count;
+  }
+
+  size_t pass_count() const {
+    return _pass_ends.size();
+  }
+
+  // Size of the encoded trace.
+  size_t byte_count() const {
+    return _bytes.size();
+  }
+
+  // Number of swaps made in the first passes passes.
+  size_t swaps_before_pass(size_t passes) const {
+    assert(passes <= pass_count());
+    return (passes == 0) ? 0 : _pass_ends[passes - 1];
+  }
+
+  // Call visit(index) for each of the first swap_limit swaps, in order.
+  template <typename visitor>
+  void for_each_swap(size_t swap_limit, visitor visit) const {
+    assert(swap_limit <= swap_count());
+    size_t index = 0, done = 0, pos = 0;
+    while (done < swap_limit) {
+      uint64_t value = get_varint(_bytes, pos);
+      if (value == 0) {
+        continue; // end of a pass
+      }
+      index = next_index(index, value);
+      visit(index);
+      done++;
+    }
+  }
+
+  // Binary format: 8 byte magic, 8 byte little-endian length, then the
+  // encoded bytes.
+  void write(std::ostream& out) const {
+    uint64_t length = _bytes.size();
+    uint8_t length_bytes[8];
+    for (int i = 0; i < 8; ++i) {
+      length_bytes[i] = uint8_t(length >> (8 * i));
+    }
+    out.write(magic(), 8);
+    out.write(reinterpret_cast<const char*>(length_bytes), 8);
+    out.write(reinterpret_cast<const char*>(_bytes.data()), _bytes.size());
+  }
+
+  // Read a trace written by write(). Throws std::runtime_error when the
+  // input is not a complete trace.
+  static swap_trace read(std::istream& in) {
+    char head[8];
+    uint8_t length_bytes[8];
+    if (!in.read(head, 8) || std::memcmp(head, magic(), 8) != 0
+        || !in.read(reinterpret_cast<char*>(length_bytes), 8)) {
+      throw std::runtime_error("not a swap trace");
+    }
+    uint64_t length = 0;
+    for (int i = 0; i < 8; ++i) {
+      length |= uint64_t(length_bytes[i]) << (8 * i);
+    }
+
+    // read a block at a time rather than allocating length bytes up
+    // front, so that a corrupt length cannot trigger a huge allocation
+    const size_t block = 1 << 16;
+    std::vector<uint8_t> bytes;
+    while (bytes.size() < length) {
+      size_t start = bytes.size();
+      size_t count = size_t(std::min<uint64_t>(length - start, block));
+      bytes.resize(start + count);
+      if (!in.read(reinterpret_cast<char*>(&bytes[start]), count)) {
+        throw std::runtime_error("truncated swap trace");
+      }
+    }
+
+    // re-record the swaps so the pass boundaries and counts are rebuilt
+    swap_trace result;
+    size_t index = 0, pos = 0;
+    while (pos < bytes.size()) {
+      uint64_t value = get_varint(bytes, pos);
+      if (value == 0) {
+        result.end_pass();
+      } else {
+        index = next_index(index, value);
+        result.record_swap(index);
+      }
+    }
+    return result;
+  }
+};
+
+// Rebuild the disk_state reached after the first swap_limit swaps of
+// trace, starting from before, the row the traced sort started with.
+disk_state replay(const disk_state& before, const swap_trace& trace,
+                  size_t swap_limit) {
+  disk_state result = before;
+  trace.for_each_swap(swap_limit, [&](size_t index) {
+    result.swap(index);
+  });
+  return result;
+}
+
+// Rebuild the disk_state reached after the first passes passes of trace.
+disk_state replay_passes(const disk_state& before, const swap_trace& trace,
+                         size_t passes) {
+  return replay(before, trace, trace.swaps_before_pass(passes));
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// work_stealing.hpp
+//
+// Run a batch of independent tasks on a group of threads that steal work
+// from each other.
+//
+// How to use:
+//
+//    std::vector<std::function<void()>> tasks;
+//    // push_back one function per independent piece of work
+//    run_work_stealing(tasks);
+//    // every task has finished here
+//
+// Tasks are dealt out to the threads' own queues in turn. A thread runs
+// tasks from the back of its own queue, and once that is empty takes
+// tasks from the front of another thread's queue, so threads that drew
+// cheap tasks help out the ones that drew expensive tasks.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads to use when a caller asks for 0: one per core.
+unsigned default_thread_count() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Run every task in tasks on thread_count threads (0 for one per core),
+// and return once all of them have finished. Tasks must not add more
+// tasks.
+void run_work_stealing(const std::vector<std::function<void()>>& tasks,
+                       unsigned thread_count = 0) {
+  if (thread_count == 0) {
+    thread_count = default_thread_count();
+  }
+  thread_count = unsigned(std::min<size_t>(thread_count, tasks.size()));
+  if (thread_count == 0) {
+    return;
+  }
+
+  struct task_queue {
+    std::mutex mutex;
+    std::deque<const std::function<void()>*> tasks;
+  };
+
+  std::vector<std::unique_ptr<task_queue>> queues;
+  for (unsigned t = 0; t < thread_count; ++t) {
+    queues.emplace_back(new task_queue);
+  }
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    queues[i % thread_count]->tasks.push_back(&tasks[i]);
+  }
+
+  auto worker = [&](unsigned self) {
+    while (true) {
+      const std::function<void()>* task = nullptr;
+
+      {
+        std::lock_guard<std::mutex> lock(queues[self]->mutex);
+        if (!queues[self]->tasks.empty()) {
+          task = queues[self]->tasks.back();
+          queues[self]->tasks.pop_back();
+        }
+      }
+
+      for (unsigned i = 1; task == nullptr && i < thread_count; ++i) {
+        auto& victim = *queues[(self + i) % thread_count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+          task = victim.tasks.front();
+          victim.tasks.pop_front();
+        }
+      }
+
+      // no task is queued anywhere, and tasks never add tasks, so this
+      // thread is done
+      if (task == nullptr) {
+        return;
+      }
+      (*task)();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < thread_count; ++t) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
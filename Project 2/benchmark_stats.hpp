@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark_stats.hpp
+//
+// Summary statistics for repeated timings, and least-squares fits of how
+// the times grow with the input size.
+//
+// How to use:
+//
+//    std::vector<double> seconds = ...;      // one entry per repetition
+//    auto summary = summarize(seconds);      // median, MAD, percentiles
+//
+//    // exponent k of time ~ n^k, from (n, median seconds) pairs
+//    auto fit = fit_power_law(sizes, medians);
+//    fit.slope;
+//
+//    // base b of time ~ b^n, as log2(b)
+//    auto fit = fit_exponential(sizes, medians);
+//
+// The median and the median absolute deviation are used rather than the
+// mean and standard deviation, since a few runs slowed down by the rest
+// of the system would otherwise dominate both.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+// Statistics of one set of timings.
+struct sample_summary {
+  size_t count;
+  double min, max;
+  double median;
+  // median absolute deviation from the median
+  double mad;
+  double p10, p90;
+};
+
+// Fit of y = intercept + slope * x.
+struct line_fit {
+  double slope;
+  double intercept;
+  // fraction of the variance of y explained by the line, 1 when every
+  // point lies on it
+  double r_squared;
+};
+
+// The p-th percentile, 0 <= p <= 100, of sorted, interpolating linearly
+// between the two nearest values.
+double percentile(const std::vector<double>& sorted, double p) {
+  assert(!sorted.empty());
+  assert(p >= 0 && p <= 100);
+  double rank = p / 100 * double(sorted.size() - 1);
+  size_t below = size_t(rank);
+  if (below + 1 >= sorted.size()) {
+    return sorted.back();
+  }
+  double fraction = rank - double(below);
+  return sorted[below] + fraction * (sorted[below + 1] - sorted[below]);
+}
+
+sample_summary summarize(std::vector<double> samples) {
+  assert(!samples.empty());
+  std::sort(samples.begin(), samples.end());
+
+  sample_summary result;
+  result.count = samples.size();
+  result.min = samples.front();
+  result.max = samples.back();
+  result.median = percentile(samples, 50);
+  result.p10 = percentile(samples, 10);
+  result.p90 = percentile(samples, 90);
+
+  std::vector<double> deviations(samples.size());
+  for (size_t i = 0; i < samples.size(); ++i) {
+    deviations[i] = std::fabs(samples[i] - result.median);
+  }
+  std::sort(deviations.begin(), deviations.end());
+  result.mad = percentile(deviations, 50);
+
+  return result;
+}
+
+// Ordinary least-squares line through the points (x[i], y[i]). Needs at
+// least two distinct x values.
+line_fit fit_line(const std::vector<double>& x, const std::vector<double>& y) {
+  assert(x.size() == y.size());
+  assert(x.size() >= 2);
+
+  const double n = double(x.size());
+  double mean_x = 0, mean_y = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    mean_x += x[i];
+    mean_y += y[i];
+  }
+  mean_x /= n;
+  mean_y /= n;
+
+  double sxx = 0, sxy = 0, syy = 0;
+  for (size_t i = 0; i < x.size(); ++i) {
+    sxx += (x[i] - mean_x) * (x[i] - mean_x);
+    sxy += (x[i] - mean_x) * (y[i] - mean_y);
+    syy += (y[i] - mean_y) * (y[i] - mean_y);
+  }
+  assert(sxx > 0);
+
+  line_fit result;
+  result.slope = sxy / sxx;
+  result.intercept = mean_y - result.slope * mean_x;
+  result.r_squared = (syy > 0) ? (sxy * sxy) / (sxx * syy) : 1;
+  return result;
+}
+
+// Fit of log(seconds) against log(n): the slope is k in time ~ n^k.
+line_fit fit_power_law(const std::vector<double>& n, const std::vector<double>& seconds) {
+  std::vector<double> x(n.size()), y(n.size());
+  for (size_t i = 0; i < n.size(); ++i) {
+    assert(n[i] > 0 && seconds[i] > 0);
+    x[i] = std::log(n[i]);
+    y[i] = std::log(seconds[i]);
+  }
+  return fit_line(x, y);
+}
+
+// Fit of log2(seconds) against n: the slope is log2(b) in time ~ b^n, so
+// 1 when the time doubles with every element.
+line_fit fit_exponential(const std::vector<double>& n, const std::vector<double>& seconds) {
+  std::vector<double> y(n.size());
+  for (size_t i = 0; i < n.size(); ++i) {
+    assert(seconds[i] > 0);
+    y[i] = std::log2(seconds[i]);
+  }
+  return fit_line(n, y);
+}
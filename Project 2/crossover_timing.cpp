@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// crossover_timing.cpp
+//
+// Compares the O(n^2) end-to-beginning lengths, scalar and AVX2, against
+// the O(n log n) patience lengths for n from 16 to 16384, and prints the
+// largest n at which the vectorized quadratic kernel was still faster.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <iostream>
+
+#include "timer.hpp"
+
+#include "subsequence.hpp"
+
+void print_bar() {
+  std::cout << std::string(79, '-') << std::endl;
+}
+
+// Average seconds per call of f, repeating it until at least 0.05 seconds
+// have passed.
+template <typename Function>
+double seconds_per_call(Function f) {
+  Timer timer;
+  size_t calls = 0;
+  double elapsed;
+  do {
+    f();
+    calls++;
+    elapsed = timer.elapsed();
+  } while (elapsed < 0.05);
+  return elapsed / calls;
+}
+
+int main() {
+
+  print_bar();
+  std::cout << "AVX2 "
+            << (subsequence_detail::cpu_has_avx2() ? "available" : "not available")
+            << std::endl;
+  std::cout << "n, scalar quadratic seconds, vectorized quadratic seconds, patience seconds"
+            << std::endl;
+  print_bar();
+
+  size_t crossover = 0;
+  for (size_t n = 16; n <= 16384; n *= 2) {
+    // Use a hardcoded seed for reproducibility between runs.
+    auto input = random_sequence(n, 0, 1000000);
+
+    std::vector<uint32_t> scalar, vectorized, patience;
+    double scalar_elapsed = seconds_per_call([&]() {
+      scalar = longest_nondecreasing_lengths_quadratic(input, false);
+    });
+    double vectorized_elapsed = seconds_per_call([&]() {
+      vectorized = longest_nondecreasing_lengths_quadratic(input);
+    });
+    double patience_elapsed = seconds_per_call([&]() {
+      patience = longest_nondecreasing_lengths(input);
+    });
+
+    assert(scalar == patience && vectorized == patience);
+
+    if (vectorized_elapsed < patience_elapsed) {
+      crossover = n;
+    }
+
+    std::cout << n << ", "
+              << scalar_elapsed << ", "
+              << vectorized_elapsed << ", "
+              << patience_elapsed << std::endl;
+  }
+
+  print_bar();
+  if (crossover == 0) {
+    std::cout << "patience was faster at every n" << std::endl;
+  } else {
+    std::cout << "vectorized quadratic was faster up to n = " << crossover << std::endl;
+  }
+  print_bar();
+
+  return 0;
+}
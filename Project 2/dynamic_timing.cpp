@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamic_timing.cpp
+//
+// Compares lnds_dynamic against rerunning the patience algorithm after
+// every change, on update-heavy workloads over 10^5 elements: random
+// point updates read back every 100 updates, point updates to the last
+// 1% of the sequence read back after each one, and appends and pops
+// read back after each one. Prints the average time per operation for
+// each.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "timer.hpp"
+
+#include "lnds_dynamic.hpp"
+#include "subsequence.hpp"
+
+void print_bar() {
+  std::cout << std::string(79, '-') << std::endl;
+}
+
+// Run operations steps of workload, one change each, reading the length
+// after every read_every changes. workload(gen, values, dynamic) makes the
+// change to values, and to dynamic unless it is null. Prints the
+// average seconds per change with lnds_dynamic and with recomputing.
+template <typename Workload>
+void run(const std::string& name, const sequence& input, size_t operations,
+         size_t read_every, Workload workload) {
+
+  size_t dynamic_total = 0, recompute_total = 0;
+
+  // Use a hardcoded seed for reproducibility between runs.
+  std::mt19937 gen(1);
+  sequence values(input);
+  lnds_dynamic dynamic(input);
+  Timer timer;
+  for (size_t op = 1; op <= operations; ++op) {
+    workload(gen, values, &dynamic);
+    if (op % read_every == 0) {
+      dynamic_total += dynamic.length();
+    }
+  }
+  double dynamic_elapsed = timer.elapsed() / operations;
+
+  gen.seed(1);
+  values = input;
+  timer.reset();
+  for (size_t op = 1; op <= operations; ++op) {
+    workload(gen, values, static_cast<lnds_dynamic*>(nullptr));
+    if (op % read_every == 0) {
+      recompute_total += longest_nondecreasing_patience(values).size();
+    }
+  }
+  double recompute_elapsed = timer.elapsed() / operations;
+
+  assert(dynamic_total == recompute_total);
+
+  std::cout << name << ", "
+            << dynamic_elapsed << ", "
+            << recompute_elapsed << std::endl;
+}
+
+int main() {
+
+  const size_t n = 100000;
+  auto input = random_sequence(n, 0, 1000000);
+  std::uniform_int_distribution<int> value(0, 1000000);
+
+  print_bar();
+  std::cout << "n = " << n << std::endl
+            << "workload, dynamic seconds/op, recompute seconds/op" << std::endl;
+  print_bar();
+
+  run("random updates, read every 100", input, 3000, 100,
+      [&](std::mt19937& gen, sequence& values, lnds_dynamic* dynamic) {
+        size_t i = gen() % values.size();
+        int x = value(gen);
+        values[i] = x;
+        if (dynamic) {
+          dynamic->set(i, x);
+        }
+      });
+
+  run("updates to the last 1%, read every 1", input, 300, 1,
+      [&](std::mt19937& gen, sequence& values, lnds_dynamic* dynamic) {
+        size_t i = values.size() - 1 - gen() % (values.size() / 100);
+        int x = value(gen);
+        values[i] = x;
+        if (dynamic) {
+          dynamic->set(i, x);
+        }
+      });
+
+  run("appends and pops, read every 1", input, 300, 1,
+      [&](std::mt19937& gen, sequence& values, lnds_dynamic* dynamic) {
+        if (gen() % 2 == 0 || values.size() <= 1) {
+          int x = value(gen);
+          values.push_back(x);
+          if (dynamic) {
+            dynamic->push_back(x);
+          }
+        } else {
+          values.pop_back();
+          if (dynamic) {
+            dynamic->pop_back();
+          }
+        }
+      });
+
+  print_bar();
+
+  return 0;
+}
@@ -0,0 +1,269 @@
+///////////////////////////////////////////////////////////////////////////////
+// lnds_count.hpp
+//
+// Counting and listing every longest non-decreasing subsequence of a
+// sequence, not just one of them.
+//
+// How to use:
+//
+//    auto counted = count_longest_nondecreasing(A);  // O(n log n)
+//    counted.length;                // length of a longest subsequence
+//    counted.count;                 // how many there are, modulo 2^64
+//    counted.exact;                 // false if count wrapped around
+//
+//    lnds_enumerator all(A);
+//    sequence R;
+//    while (all.next(R)) {
+//      // R is the next longest subsequence
+//    }
+//
+// Two subsequences are counted as different when they use different
+// positions of A, even if their values are equal.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "subsequence.hpp"
+
+// Output of count_longest_nondecreasing.
+struct lnds_count {
+  size_t length;
+  // number of longest subsequences, modulo 2^64
+  uint64_t count;
+  // true when count is the true number, not a wrapped-around one
+  bool exact;
+};
+
+namespace lnds_count_detail {
+
+// Longest subsequence length from some set of elements, how many
+// subsequences have that length, and the count capped at UINT64_MAX,
+// which tells whether count has wrapped around.
+struct best {
+  uint32_t length = 0;
+  uint64_t count = 0;
+  uint64_t capped = 0;
+
+  void merge(const best& other) {
+    if (other.length > length) {
+      *this = other;
+    } else if (other.length == length) {
+      count += other.count;
+      capped = (capped > UINT64_MAX - other.capped) ? UINT64_MAX
+                                                    : capped + other.capped;
+    }
+  }
+};
+
+} // namespace lnds_count_detail
+
+// Length and number of the longest non-decreasing subsequences of A, in
+// O(n log n) time.
+//
+// Going from the end to the beginning, a Fenwick tree indexed by the rank
+// of each value, largest first, holds for the elements seen so far the
+// best length starting at a value of each rank and how many subsequences
+// reach it. The elements that may follow A[i] are those with a value of
+// at least A[i], which is a prefix of the tree.
+lnds_count count_longest_nondecreasing(const sequence& A) {
+  using lnds_count_detail::best;
+
+  const size_t n = A.size();
+  if (n == 0) {
+    // the empty subsequence
+    return lnds_count{0, 1, true};
+  }
+
+  sequence values(A);
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  const size_t m = values.size();
+
+  // fenwick[r] covers ranks (r - (r & -r), r], one-based, with rank 1 the
+  // largest value
+  std::vector<best> fenwick(m + 1);
+  best total;
+
+  for (size_t i = n; i-- > 0; ) {
+    size_t rank = m - size_t(std::lower_bound(values.begin(), values.end(), A[i])
+                             - values.begin());
+
+    best found;
+    for (size_t r = rank; r > 0; r -= r & (~r + 1)) {
+      found.merge(fenwick[r]);
+    }
+
+    best here;
+    here.length = found.length + 1;
+    here.count = (found.length == 0) ? 1 : found.count;
+    here.capped = (found.length == 0) ? 1 : found.capped;
+
+    for (size_t r = rank; r <= m; r += r & (~r + 1)) {
+      fenwick[r].merge(here);
+    }
+    total.merge(here);
+  }
+
+  return lnds_count{total.length, total.count, total.capped < UINT64_MAX};
+}
+
+// Lists the longest non-decreasing subsequences of a sequence one at a
+// time, in lexicographic order of their positions.
+//
+// Level k of a subsequence of length L is its (k+1)-th element, which must
+// start a subsequence of length L - k. Every element whose length matches
+// the one needed at its level, and whose value is at least the previous
+// element's, can be completed into a longest subsequence, so the search
+// never backs out of a dead end. The positions are grouped by the length
+// they start, in order, and each position keeps where the group one level
+// below starts after it. next() then scans each group at most twice,
+// once backing up and once going down, so it takes O(n) time, with O(n)
+// memory however many subsequences there are.
+class lnds_enumerator {
+private:
+  sequence _values;
+  size_t _length;
+  // positions grouped by the length of the longest subsequence they
+  // start, group h at [_group_begin[h], _group_begin[h + 1]), increasing
+  std::vector<uint32_t> _by_group;
+  std::vector<size_t> _group_begin;
+  // for the position in each slot of _by_group, the first slot of the
+  // group one below holding a later position
+  std::vector<uint32_t> _next_lower;
+  // positions of the current subsequence, and their slots
+  std::vector<size_t> _indices;
+  std::vector<uint32_t> _slots;
+  bool _started, _done;
+
+  size_t group_end(size_t level) const {
+    return _group_begin[_length - level + 1];
+  }
+
+  // First slot from onwards, in the group for level, whose position can
+  // take place level of the current subsequence, or the end of the group.
+  size_t find(size_t level, size_t from) const {
+    const size_t end = group_end(level);
+    for (size_t s = from; s < end; ++s) {
+      if (level == 0 || _values[_indices[level - 1]] <= _values[_by_group[s]]) {
+        return s;
+      }
+    }
+    return end;
+  }
+
+  void pop() {
+    _indices.pop_back();
+    _slots.pop_back();
+  }
+
+public:
+
+  explicit lnds_enumerator(const sequence& A)
+    : _values(A),
+      _length(0),
+      _started(false),
+      _done(false) {
+      const size_t n = A.size();
+      auto starts = longest_nondecreasing_lengths(A);
+      for (auto h : starts) {
+        _length = std::max<size_t>(_length, h);
+      }
+
+      _group_begin.assign(_length + 2, 0);
+      for (auto h : starts) {
+        _group_begin[h + 1]++;
+      }
+      for (size_t h = 1; h < _group_begin.size(); ++h) {
+        _group_begin[h] += _group_begin[h - 1];
+      }
+
+      std::vector<uint32_t> slot(n);
+      std::vector<size_t> filled(_group_begin.begin(), _group_begin.end() - 1);
+      _by_group.resize(n);
+      for (size_t j = 0; j < n; ++j) {
+        slot[j] = uint32_t(filled[starts[j]]++);
+        _by_group[slot[j]] = uint32_t(j);
+      }
+
+      // right to left, leftmost[h] is the slot of the leftmost position
+      // seen so far in group h
+      std::vector<uint32_t> leftmost(_length + 1);
+      for (size_t h = 0; h <= _length; ++h) {
+        leftmost[h] = uint32_t(_group_begin[h + 1]);
+      }
+      _next_lower.resize(n);
+      for (size_t j = n; j-- > 0; ) {
+        const uint32_t h = starts[j];
+        _next_lower[slot[j]] = leftmost[h - 1];
+        leftmost[h] = slot[j];
+      }
+
+      _indices.reserve(_length);
+      _slots.reserve(_length);
+  }
+
+  // Length of every subsequence listed.
+  size_t length() const {
+    return _length;
+  }
+
+  // Positions in A of the subsequence last returned by next().
+  const std::vector<size_t>& indices() const {
+    return _indices;
+  }
+
+  // Store the next longest subsequence in out and return true, or return
+  // false once all of them have been listed.
+  bool next(sequence& out) {
+    if (_done) {
+      return false;
+    }
+
+    size_t level = 0, from;
+    if (!_started) {
+      _started = true;
+      if (_length == 0) {
+        _done = true;
+        out.clear();
+        return true;
+      }
+      from = _group_begin[_length];
+    } else {
+      level = _indices.size() - 1;
+      from = _slots.back() + 1;
+      pop();
+    }
+
+    while (true) {
+      size_t s = find(level, from);
+      if (s == group_end(level)) {
+        if (level == 0) {
+          _done = true;
+          return false;
+        }
+        level--;
+        from = _slots.back() + 1;
+        pop();
+        continue;
+      }
+
+      _indices.push_back(_by_group[s]);
+      _slots.push_back(uint32_t(s));
+      if (_indices.size() == _length) {
+        out.resize(_length);
+        for (size_t k = 0; k < _length; ++k) {
+          out[k] = _values[_indices[k]];
+        }
+        return true;
+      }
+      level++;
+      from = _next_lower[s];
+    }
+  }
+};
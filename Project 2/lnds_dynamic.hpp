@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// lnds_dynamic.hpp
+//
+// Longest non-decreasing subsequence length of a sequence that changes:
+// values are appended and popped at the back, and any value can be
+// overwritten.
+//
+// How to use:
+//
+//    lnds_dynamic dynamic(A);       // O(n log n)
+//    dynamic.push_back(x);          // O(log n)
+//    dynamic.pop_back();            // O(1)
+//    dynamic.set(i, x);             // O(n - i)
+//    dynamic.length();              // O(1) after pushes and pops; after
+//                                   // set(i, ...) O((n - i) log n), once
+//
+// The patience tails of the prefix are kept for as many elements as are
+// known to be unchanged, with a log of how each element changed them, so
+// the last element can be taken back out in O(1). Overwriting element i
+// rolls the tails back to just before i, and length() replays only from
+// there. Many updates between reads therefore share one replay of the
+// suffix after the earliest of them, and updates near the back, the usual
+// case for corrections to a time series, cost little.
+//
+// Point updates are not sublinear in general: one at a random position
+// followed by a read costs about half of rerunning the patience
+// algorithm on the whole sequence.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "subsequence.hpp"
+
+class lnds_dynamic {
+private:
+
+  // How adding one element changed the tails: it replaced the tail at
+  // index, which had value old, or added a new tail when grew is set.
+  struct change {
+    uint32_t index;
+    bool grew;
+    int old;
+  };
+
+  sequence _values;
+
+  // tails[k] is the smallest value ending a non-decreasing subsequence of
+  // length k+1 among the first _applied elements
+  mutable std::vector<int> _tails;
+  mutable std::vector<change> _changes;
+  mutable size_t _applied;
+
+  void apply_next() const {
+    const int x = _values[_applied];
+    // upper_bound, so that x can follow an equal value
+    auto it = std::upper_bound(_tails.begin(), _tails.end(), x);
+    change c;
+    c.index = uint32_t(it - _tails.begin());
+    if (it == _tails.end()) {
+      c.grew = true;
+      c.old = 0;
+      _tails.push_back(x);
+    } else {
+      c.grew = false;
+      c.old = *it;
+      *it = x;
+    }
+    _changes.push_back(c);
+    _applied++;
+  }
+
+  void undo_last() const {
+    const change& c = _changes.back();
+    if (c.grew) {
+      _tails.pop_back();
+    } else {
+      _tails[c.index] = c.old;
+    }
+    _changes.pop_back();
+    _applied--;
+  }
+
+  void catch_up() const {
+    while (_applied < _values.size()) {
+      apply_next();
+    }
+  }
+
+public:
+
+  lnds_dynamic()
+    : _applied(0) { }
+
+  explicit lnds_dynamic(const sequence& values)
+    : _values(values), _applied(0) {
+      _changes.reserve(values.size());
+      catch_up();
+  }
+
+  size_t size() const {
+    return _values.size();
+  }
+
+  bool empty() const {
+    return _values.empty();
+  }
+
+  int get(size_t i) const {
+    assert(i < size());
+    return _values[i];
+  }
+
+  const sequence& values() const {
+    return _values;
+  }
+
+  void push_back(int x) {
+    _values.push_back(x);
+    if (_applied + 1 == _values.size()) {
+      apply_next();
+    }
+  }
+
+  void pop_back() {
+    assert(!empty());
+    if (_applied == _values.size()) {
+      undo_last();
+    }
+    _values.pop_back();
+  }
+
+  // Overwrite element i with x, undoing the elements from i on; the next
+  // length() replays them.
+  void set(size_t i, int x) {
+    assert(i < size());
+    if (_values[i] == x) {
+      return;
+    }
+    while (_applied > i) {
+      undo_last();
+    }
+    _values[i] = x;
+  }
+
+  // Length of the longest non-decreasing subsequence of the values.
+  size_t length() const {
+    catch_up();
+    return _tails.size();
+  }
+};
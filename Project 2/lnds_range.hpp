@@ -0,0 +1,414 @@
+///////////////////////////////////////////////////////////////////////////////
+// lnds_range.hpp
+//
+// Longest non-decreasing subsequence length of any subarray of a fixed
+// sequence, after preprocessing.
+//
+// How to use:
+//
+//    lnds_range_index index(A);     // O(n log^2 n) time, O(n) memory
+//    index.length(first, last);     // LNDS length of A[first, last),
+//                                   // O(log n)
+//
+// This follows Tiskin's seaweed method. Draw a grid with one column per
+// position of A and one row per value, in sorted order, and mark the cell
+// in column i at the row of A[i]. A subsequence of A[first, last) is
+// non-decreasing exactly when its cells go down and right, so its length
+// is the longest common subsequence of A[first, last) and the sorted
+// values. Now let one "seaweed" enter at the top of every column and at
+// the left of every row, and let them travel down and right: at a marked
+// cell the two seaweeds meeting there turn, and at any other cell they
+// cross unless they have crossed before. Then
+//
+//    length(first, last) = (last - first)
+//                          - #{ s in [first, last) : the seaweed entering
+//                               column s leaves through the bottom of a
+//                               column before last }
+//
+// so once every seaweed's exit is known, each query is a two-sided range
+// count, answered with a wavelet matrix.
+//
+// Seaweeds are numbered in the order they are met walking along the
+// left edge of the grid from the bottom, then along the top edge from the
+// left; exits along the bottom edge from the left, then along the right
+// edge from the bottom. The exits of the whole grid are computed by
+// splitting the rows in half, solving each half (where the columns with
+// no mark just pass their seaweed straight down), and combining the two
+// halves with the unit-Monge matrix product, which the "steady ant"
+// algorithm computes in O(n log n) time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "subsequence.hpp"
+
+namespace lnds_range_detail {
+
+using permutation = std::vector<uint32_t>;
+
+// Sequences at most this long are combed cell by cell rather than split,
+// which is faster for small grids.
+const uint32_t SEAWEED_COMB_SIZE = 48;
+
+// Unit-Monge product of permutations P and Q of size N, stored in R: the
+// permutation with R^S(i, k) = min over j of P^S(i, j) + Q^S(j, k), where
+// X^S(i, j) counts the points (i', X[i']) with i' >= i and X[i'] < j.
+// work must have room for multiply_work(N) values.
+//
+// The middle index j is split in half, and each half multiplied
+// recursively, giving "red" points from the low half and "blue" points
+// from the high half, one per row. The product keeps the red points where
+//
+//    D(i, k) = #blue in rows < i, columns < k
+//              - #red in rows >= i, columns >= k
+//
+// is negative, and the blue ones where it is not. D only grows with i and
+// k, one step at a time, so for every row i there is a boundary column
+// b[i], the first k with D(i, k) >= 0, and b only shrinks as i grows. The
+// "ant" walks that boundary from the bottom-left corner in O(N), and a
+// row whose own point is on the wrong side of it gets its point at
+// b[i] - 1 instead.
+inline size_t multiply_work(uint32_t N) {
+  return (N <= 1) ? 0 : 5 * size_t(N) + multiply_work(N - N / 2);
+}
+
+inline void multiply(const uint32_t* P, const uint32_t* Q, uint32_t N,
+                     uint32_t* R, uint32_t* work) {
+  if (N <= 1) {
+    if (N == 1) {
+      R[0] = 0;
+    }
+    return;
+  }
+  const uint32_t mid = N / 2;
+
+  uint32_t* P_sub = work;          // low half of P, then high half
+  uint32_t* Q_sub = work + N;      // low half of Q, then high half
+  uint32_t* rows = work + 2 * N;   // rows of P_sub in P
+  uint32_t* cols = work + 3 * N;   // columns of Q_sub in Q
+  uint32_t* R_sub = work + 4 * N;  // products of the halves
+  uint32_t* next = work + 5 * N;
+
+  // split P by column at mid; exactly mid rows have a column below it
+  uint32_t lo = 0, hi = mid;
+  for (uint32_t i = 0; i < N; ++i) {
+    if (P[i] < mid) {
+      rows[lo] = i;
+      P_sub[lo++] = P[i];
+    } else {
+      rows[hi] = i;
+      P_sub[hi++] = P[i] - mid;
+    }
+  }
+
+  // split Q by row at mid, renumbering the columns each half uses in
+  // order; R_sub holds the row of each column of Q until it is needed
+  for (uint32_t j = 0; j < N; ++j) {
+    R_sub[Q[j]] = j;
+  }
+  lo = 0;
+  hi = mid;
+  for (uint32_t k = 0; k < N; ++k) {
+    uint32_t j = R_sub[k];
+    if (j < mid) {
+      Q_sub[j] = lo;
+      cols[lo++] = k;
+    } else {
+      Q_sub[j] = hi - mid;
+      cols[hi++] = k;
+    }
+  }
+
+  multiply(P_sub, Q_sub, mid, R_sub, next);
+  multiply(P_sub + mid, Q_sub + mid, N - mid, R_sub + mid, next);
+
+  // column of every row's point, and row of every column's; a point is
+  // red when its row came from the low half
+  uint32_t* col = P_sub;
+  uint32_t* row = Q_sub;
+  for (uint32_t t = 0; t < mid; ++t) {
+    col[rows[t]] = cols[R_sub[t]];
+  }
+  for (uint32_t t = mid; t < N; ++t) {
+    col[rows[t]] = cols[mid + R_sub[t]];
+  }
+  for (uint32_t i = 0; i < N; ++i) {
+    row[col[i]] = i;
+  }
+
+  // the ant is at (i, k) with k = b[i]; D(N, 0) = 0 so b[N] = 0
+  uint32_t k = 0;
+  int64_t D = 0;
+  for (uint32_t i = N; i-- > 0; ) {
+    const bool red = P[i] < mid;
+    // step up from row i + 1 to row i
+    if (red ? (col[i] >= k) : (col[i] < k)) {
+      D--;
+    }
+    // step right until D(i, k) >= 0
+    while (D < 0) {
+      uint32_t r = row[k];
+      if ((P[r] < mid) ? (r >= i) : (r < i)) {
+        D++;
+      }
+      k++;
+    }
+    bool keep = red ? (col[i] < k) : (col[i] >= k);
+    R[i] = keep ? col[i] : k - 1;
+  }
+}
+
+// Seaweed exits for the grid of a, a permutation of 0, ..., n-1: a
+// permutation of the 2n seaweeds, numbered as described at the top of
+// this file, with rows numbered by value and columns by position.
+//
+// The grid is split into the rows below and above half. Each half only
+// marks the columns of its own values, so is solved as a smaller
+// permutation, and the unmarked columns are put back as seaweeds going
+// straight down. Stacking the top half on the bottom half is then one
+// unit-Monge product, with the left seaweeds of the bottom half passing
+// untouched through the top half and the right exits of the top half
+// passing untouched through the bottom half.
+inline permutation seaweed(const std::vector<uint32_t>& a) {
+  const uint32_t n = uint32_t(a.size());
+
+  if (n <= SEAWEED_COMB_SIZE) {
+    // Comb column by column. Two seaweeds have crossed before exactly
+    // when the one arriving from the left has the larger number, so the
+    // one arriving from above carries on down only if it has the larger
+    // number and the cell is unmarked; otherwise the two turn.
+    permutation exits(2 * n);
+    std::vector<uint32_t> across(n);
+    for (uint32_t v = 0; v < n; ++v) {
+      across[v] = n - 1 - v;
+    }
+    for (uint32_t c = 0; c < n; ++c) {
+      uint32_t down = n + c;
+      for (uint32_t v = 0; v < n; ++v) {
+        if (a[c] == v || across[v] > down) {
+          std::swap(across[v], down);
+        }
+      }
+      exits[down] = c;
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+      exits[across[v]] = n + (n - 1 - v);
+    }
+    return exits;
+  }
+
+  const uint32_t mid = n / 2;
+
+  // seaweeds of the rows with values in [lo, hi), over all n columns
+  auto half = [&](uint32_t lo, uint32_t hi) {
+    const uint32_t m = hi - lo;
+    std::vector<uint32_t> cols, sub;
+    cols.reserve(m);
+    sub.reserve(m);
+    for (uint32_t c = 0; c < n; ++c) {
+      if (a[c] >= lo && a[c] < hi) {
+        cols.push_back(c);
+        sub.push_back(a[c] - lo);
+      }
+    }
+    permutation inner = seaweed(sub);
+
+    // exits of the smaller grid in the full grid
+    auto exit = [&](uint32_t e) {
+      return (e < m) ? cols[e] : n + (e - m);
+    };
+    permutation full(m + n, UINT32_MAX);
+    for (uint32_t s = 0; s < m; ++s) {
+      full[s] = exit(inner[s]);
+    }
+    for (uint32_t t = 0; t < m; ++t) {
+      full[m + cols[t]] = exit(inner[m + t]);
+    }
+    for (uint32_t c = 0; c < n; ++c) {
+      if (full[m + c] == UINT32_MAX) {
+        full[m + c] = c;
+      }
+    }
+    return full;
+  };
+
+  const uint32_t m_top = mid, m_bottom = n - mid;
+  permutation first(2 * n), second(2 * n);
+  {
+    permutation top = half(0, mid);
+    for (uint32_t s = 0; s < m_bottom; ++s) {
+      first[s] = s;
+    }
+    for (uint32_t s = 0; s < m_top + n; ++s) {
+      first[m_bottom + s] = m_bottom + top[s];
+    }
+  }
+  {
+    permutation bottom = half(mid, n);
+    std::copy(bottom.begin(), bottom.end(), second.begin());
+    for (uint32_t s = 0; s < m_top; ++s) {
+      second[m_bottom + n + s] = m_bottom + n + s;
+    }
+  }
+
+  permutation product(2 * n);
+  std::vector<uint32_t> work(multiply_work(2 * n));
+  multiply(first.data(), second.data(), 2 * n, product.data(), work.data());
+  return product;
+}
+
+// Bits of one level of a wavelet matrix, with the number of ones before
+// every 64-bit word for O(1) rank.
+class bit_vector {
+private:
+  std::vector<uint64_t> _words;
+  std::vector<uint32_t> _ones_before;
+
+public:
+  explicit bit_vector(size_t size = 0)
+    : _words(size / 64 + 1, 0) { }
+
+  void set(size_t i) {
+    _words[i / 64] |= uint64_t(1) << (i % 64);
+  }
+
+  bool get(size_t i) const {
+    return (_words[i / 64] >> (i % 64)) & 1;
+  }
+
+  void build_ranks() {
+    _ones_before.resize(_words.size());
+    uint32_t ones = 0;
+    for (size_t w = 0; w < _words.size(); ++w) {
+      _ones_before[w] = ones;
+      ones += uint32_t(__builtin_popcountll(_words[w]));
+    }
+  }
+
+  // Number of ones in [0, i).
+  size_t rank1(size_t i) const {
+    uint64_t below = _words[i / 64] & ((uint64_t(1) << (i % 64)) - 1);
+    return _ones_before[i / 64] + size_t(__builtin_popcountll(below));
+  }
+};
+
+// Static array of values in [0, 2^bits) that counts, for any range of
+// positions, the values below a bound, in O(bits) time and n * bits bits
+// of memory plus rank tables.
+class wavelet_matrix {
+private:
+  unsigned _bits;
+  std::vector<bit_vector> _levels;
+  std::vector<size_t> _zeros;
+
+public:
+  wavelet_matrix() : _bits(0) { }
+
+  wavelet_matrix(std::vector<uint32_t> values, unsigned bits)
+    : _bits(bits), _levels(bits), _zeros(bits) {
+
+      const size_t n = values.size();
+      std::vector<uint32_t> zeros, ones;
+      for (unsigned level = 0; level < bits; ++level) {
+        const unsigned shift = bits - 1 - level;
+        bit_vector& b = _levels[level];
+        b = bit_vector(n);
+        zeros.clear();
+        ones.clear();
+        for (size_t i = 0; i < n; ++i) {
+          if ((values[i] >> shift) & 1) {
+            b.set(i);
+            ones.push_back(values[i]);
+          } else {
+            zeros.push_back(values[i]);
+          }
+        }
+        b.build_ranks();
+        _zeros[level] = zeros.size();
+        std::copy(ones.begin(), ones.end(),
+                  std::copy(zeros.begin(), zeros.end(), values.begin()));
+      }
+  }
+
+  // Number of positions in [first, last) holding a value below bound.
+  size_t count_less(size_t first, size_t last, uint64_t bound) const {
+    if (bound >> _bits) {
+      return last - first;
+    }
+    size_t count = 0;
+    for (unsigned level = 0; level < _bits && first < last; ++level) {
+      const bit_vector& b = _levels[level];
+      size_t ones_first = b.rank1(first), ones_last = b.rank1(last);
+      if ((bound >> (_bits - 1 - level)) & 1) {
+        // every value here with a 0 bit is below bound
+        count += (last - first) - (ones_last - ones_first);
+        first = _zeros[level] + ones_first;
+        last = _zeros[level] + ones_last;
+      } else {
+        first -= ones_first;
+        last -= ones_last;
+      }
+    }
+    return count;
+  }
+};
+
+} // namespace lnds_range_detail
+
+class lnds_range_index {
+private:
+  size_t _size;
+  // for every column s, where its seaweed leaves through the bottom, or
+  // _size when it leaves through the right
+  lnds_range_detail::wavelet_matrix _exits;
+
+public:
+
+  explicit lnds_range_index(const sequence& A)
+    : _size(A.size()) {
+
+      assert(A.size() < UINT32_MAX / 4);
+      const uint32_t n = uint32_t(A.size());
+
+      // Rank the elements by value, then by position, so that a
+      // non-decreasing subsequence of A is an increasing subsequence of a.
+      std::vector<uint32_t> order(n), a(n);
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(),
+                       [&](uint32_t i, uint32_t j) { return A[i] < A[j]; });
+      for (uint32_t r = 0; r < n; ++r) {
+        a[order[r]] = r;
+      }
+
+      auto exits = lnds_range_detail::seaweed(a);
+
+      // the seaweed entering column s is number n + s
+      std::vector<uint32_t> bottom(n);
+      for (uint32_t s = 0; s < n; ++s) {
+        bottom[s] = std::min(exits[n + s], n);
+      }
+
+      unsigned bits = 1;
+      while ((uint64_t(1) << bits) <= n) {
+        bits++;
+      }
+      _exits = lnds_range_detail::wavelet_matrix(std::move(bottom), bits);
+  }
+
+  size_t size() const {
+    return _size;
+  }
+
+  // Length of the longest non-decreasing subsequence of A[first, last).
+  size_t length(size_t first, size_t last) const {
+    assert(first <= last && last <= _size);
+    return (last - first) - _exits.count_less(first, last, last);
+  }
+};
@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+// lnds_stream.hpp
+//
+// Online longest non-decreasing subsequence over a stream of values that
+// may never end.
+//
+// How to use:
+//
+//    lnds_stream stream(true);      // true: keep what is needed to
+//                                   // rebuild the subsequence
+//    stream.push(x);                // O(log length()) per value
+//    stream.push(batch);            // or a whole sequence at once
+//    stream.length();               // O(1), at any time
+//    stream.subsequence();          // O(length()), on demand
+//
+// Only the patience tails, O(length()) values, are needed for length().
+// Rebuilding the subsequence also needs, for every value pushed, the
+// value and how far back its predecessor in the best subsequence ending
+// there is. Those records are kept in fixed-size chunks, and when a spill
+// file is given, all but the newest memory_chunks chunks are written out
+// to it, so memory stays bounded however long the stream runs.
+//
+// A distance takes 32 bits, so a record is 8 bytes rather than the 12 a
+// full 64-bit index would take. The rare predecessor 2^32 - 1 or more
+// values back is kept in a short list beside its chunk, and found by
+// binary search. basic_lnds_stream takes the distance type as a parameter
+// so that the tests can exercise that list with narrower distances.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "subsequence.hpp"
+
+// Predecessor index recorded for an element that starts its subsequence.
+const uint64_t LNDS_NO_PREDECESSOR = UINT64_MAX;
+
+template <typename Distance>
+class basic_lnds_stream {
+private:
+  static_assert(std::is_unsigned<Distance>::value && sizeof(Distance) <= sizeof(uint32_t),
+                "distances are unsigned and at most 32 bits");
+
+  // distance recorded for an element that starts its subsequence, and
+  // for one whose predecessor is in the far list
+  static const Distance NONE = 0;
+  static const Distance FAR = std::numeric_limits<Distance>::max();
+
+  struct chunk {
+    std::vector<Distance> distances;
+    std::vector<int> values;
+    // predecessors FAR or more back, by increasing offset in the chunk
+    std::vector<uint32_t> far_offsets;
+    std::vector<uint64_t> far_predecessors;
+    bool spilled = false;
+    // where in the spill file, and how long the far list is, once spilled
+    uint64_t spill_at = 0;
+    size_t far_count = 0;
+  };
+
+  bool _reconstructible;
+  size_t _chunk_records;
+  size_t _memory_chunks;
+  std::string _spill_path;
+  mutable std::fstream _spill;
+  uint64_t _spill_end;
+
+  // tails[k] is the smallest value ending a non-decreasing subsequence of
+  // length k+1 so far, and tail_indices[k] the index of that element
+  std::vector<int> _tails;
+  std::vector<uint64_t> _tail_indices;
+  uint64_t _count;
+
+  std::vector<chunk> _chunks;
+  // chunks before this one are spilled
+  size_t _first_in_memory;
+
+  template <typename T>
+  void write(const std::vector<T>& values) {
+    _spill.write(reinterpret_cast<const char*>(values.data()),
+                 std::streamsize(values.size() * sizeof(T)));
+  }
+
+  template <typename T>
+  void read(uint64_t at, T& value) const {
+    _spill.seekg(std::streamoff(at));
+    _spill.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!_spill) {
+      throw std::runtime_error("failed reading " + _spill_path);
+    }
+  }
+
+  // Written as the distances, the values, then the far list's offsets and
+  // predecessors.
+  void spill_oldest() {
+    chunk& old = _chunks[_first_in_memory];
+    old.spill_at = _spill_end;
+    old.far_count = old.far_offsets.size();
+    _spill.seekp(std::streamoff(old.spill_at));
+    write(old.distances);
+    write(old.values);
+    write(old.far_offsets);
+    write(old.far_predecessors);
+    if (!_spill) {
+      throw std::runtime_error("failed writing " + _spill_path);
+    }
+    _spill_end += _chunk_records * (sizeof(Distance) + sizeof(int))
+                  + old.far_count * (sizeof(uint32_t) + sizeof(uint64_t));
+    std::vector<Distance>().swap(old.distances);
+    std::vector<int>().swap(old.values);
+    std::vector<uint32_t>().swap(old.far_offsets);
+    std::vector<uint64_t>().swap(old.far_predecessors);
+    old.spilled = true;
+    _first_in_memory++;
+  }
+
+  void record(uint64_t predecessor, int value) {
+    if (_chunks.empty() || _chunks.back().values.size() == _chunk_records) {
+      _chunks.emplace_back();
+      _chunks.back().distances.reserve(_chunk_records);
+      _chunks.back().values.reserve(_chunk_records);
+      if (_spill.is_open() && _chunks.size() - _first_in_memory > _memory_chunks) {
+        spill_oldest();
+      }
+    }
+
+    chunk& c = _chunks.back();
+    Distance distance = NONE;
+    if (predecessor != LNDS_NO_PREDECESSOR) {
+      uint64_t back = _count - predecessor;
+      if (back < FAR) {
+        distance = Distance(back);
+      } else {
+        distance = FAR;
+        c.far_offsets.push_back(uint32_t(c.values.size()));
+        c.far_predecessors.push_back(predecessor);
+      }
+    }
+    c.distances.push_back(distance);
+    c.values.push_back(value);
+  }
+
+  // Predecessor of the far element at offset in spilled chunk c.
+  uint64_t spilled_far(const chunk& c, uint32_t offset) const {
+    const uint64_t offsets_at = c.spill_at + _chunk_records * (sizeof(Distance) + sizeof(int));
+    size_t low = 0, high = c.far_count;
+    while (high - low > 1) {
+      size_t middle = low + (high - low) / 2;
+      uint32_t at_middle;
+      read(offsets_at + middle * sizeof(uint32_t), at_middle);
+      if (at_middle <= offset) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+    uint64_t predecessor;
+    read(offsets_at + c.far_count * sizeof(uint32_t) + low * sizeof(uint64_t), predecessor);
+    return predecessor;
+  }
+
+  // Value and predecessor of element i, from memory or the spill file.
+  void lookup(uint64_t i, uint64_t& predecessor, int& value) const {
+    const chunk& c = _chunks[i / _chunk_records];
+    const uint32_t offset = uint32_t(i % _chunk_records);
+    Distance distance;
+    if (!c.spilled) {
+      distance = c.distances[offset];
+      value = c.values[offset];
+    } else {
+      read(c.spill_at + offset * sizeof(Distance), distance);
+      read(c.spill_at + _chunk_records * sizeof(Distance) + offset * sizeof(int), value);
+    }
+
+    if (distance == NONE) {
+      predecessor = LNDS_NO_PREDECESSOR;
+    } else if (distance != FAR) {
+      predecessor = i - distance;
+    } else if (c.spilled) {
+      predecessor = spilled_far(c, offset);
+    } else {
+      auto it = std::lower_bound(c.far_offsets.begin(), c.far_offsets.end(), offset);
+      assert(it != c.far_offsets.end() && *it == offset);
+      predecessor = c.far_predecessors[it - c.far_offsets.begin()];
+    }
+  }
+
+public:
+
+  // When reconstructible is false only length() is available, in
+  // O(length()) memory. Otherwise every value pushed is recorded in chunks
+  // of chunk_records; with a non-empty spill_path, chunks beyond the
+  // newest memory_chunks are moved to that file, which is overwritten.
+  explicit basic_lnds_stream(bool reconstructible = false,
+                             const std::string& spill_path = "",
+                             size_t memory_chunks = 16,
+                             size_t chunk_records = 1 << 16)
+    : _reconstructible(reconstructible),
+      _chunk_records(chunk_records),
+      _memory_chunks(memory_chunks),
+      _spill_path(spill_path),
+      _spill_end(0),
+      _count(0),
+      _first_in_memory(0) {
+
+      assert(chunk_records > 0 && chunk_records <= UINT32_MAX);
+      assert(memory_chunks > 0);
+
+      if (reconstructible && !spill_path.empty()) {
+        _spill.open(spill_path, std::ios::in | std::ios::out
+                                | std::ios::binary | std::ios::trunc);
+        if (!_spill) {
+          throw std::runtime_error("cannot open " + spill_path);
+        }
+      }
+  }
+
+  basic_lnds_stream(const basic_lnds_stream&) = delete;
+  basic_lnds_stream& operator= (const basic_lnds_stream&) = delete;
+
+  void push(int x) {
+    // upper_bound, so that x can follow an equal value
+    auto it = std::upper_bound(_tails.begin(), _tails.end(), x);
+    size_t k = it - _tails.begin();
+
+    if (_reconstructible) {
+      record((k == 0) ? LNDS_NO_PREDECESSOR : _tail_indices[k-1], x);
+    }
+
+    if (it == _tails.end()) {
+      _tails.push_back(x);
+      _tail_indices.push_back(_count);
+    } else {
+      *it = x;
+      _tail_indices[k] = _count;
+    }
+    _count++;
+  }
+
+  void push(const sequence& batch) {
+    for (auto x : batch) {
+      push(x);
+    }
+  }
+
+  // Number of values pushed so far.
+  uint64_t count() const {
+    return _count;
+  }
+
+  // Length of the longest non-decreasing subsequence of the values pushed
+  // so far.
+  size_t length() const {
+    return _tails.size();
+  }
+
+  // One longest non-decreasing subsequence of the values pushed so far,
+  // with the smallest possible last value.
+  sequence subsequence() const {
+    assert(_reconstructible);
+
+    sequence result(length());
+    uint64_t i = _tail_indices.empty() ? LNDS_NO_PREDECESSOR : _tail_indices.back();
+    for (size_t k = result.size(); k-- > 0; ) {
+      assert(i != LNDS_NO_PREDECESSOR);
+      uint64_t predecessor;
+      lookup(i, predecessor, result[k]);
+      i = predecessor;
+    }
+    return result;
+  }
+};
+
+using lnds_stream = basic_lnds_stream<uint32_t>;
@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+// lnds_window.hpp
+//
+// Longest non-decreasing subsequence length over a sliding window: values
+// are pushed on the back and popped off the front, and the length can be
+// read at any time.
+//
+// How to use:
+//
+//    lnds_window window;
+//    window.assign(first_W_samples);  // optional, O(W log W)
+//    for (auto x : samples) {
+//      window.push_back(x);
+//      if (window.size() > W) {
+//        window.pop_front();
+//      }
+//      window.length();             // O(1)
+//    }
+//
+// For every element i of the window the engine keeps L[i], the length of
+// the longest non-decreasing subsequence of the window that starts at i,
+// and how many elements have each L. L[i] only depends on elements right
+// of i, so pop_front() leaves every other L alone and costs O(1).
+// push_back() can raise each L by at most one, and finds which ones in a
+// single right-to-left scan of simple array operations, so it costs
+// O(W) -- compared to O(W log W) for rerunning the patience algorithm on
+// the window, or O(W^2) for end-to-beginning.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include "subsequence.hpp"
+
+class lnds_window {
+private:
+  std::deque<int> _values;
+  std::deque<uint32_t> _starts;     // L[i] for each value
+  std::vector<size_t> _level_counts; // elements with each L
+  size_t _length;
+
+  // scratch for push_back, kept to avoid allocating on every push
+  std::vector<int64_t> _raised_max;
+
+public:
+
+  lnds_window()
+    : _level_counts(1, 0), _length(0) { }
+
+  size_t size() const {
+    return _values.size();
+  }
+
+  bool empty() const {
+    return _values.empty();
+  }
+
+  int front() const {
+    assert(!empty());
+    return _values.front();
+  }
+
+  // Length of the longest non-decreasing subsequence of the window.
+  size_t length() const {
+    return _length;
+  }
+
+  // Add x as the newest element.
+  //
+  // The new element starts a subsequence of length 1 on its own, so treat
+  // it as raised from level 0. Scanning leftwards, element i is raised
+  // exactly when some element j right of it with A[i] <= A[j] was raised
+  // from level L[i]-1: before the push L[i] was one more than the best
+  // such L[j], and only raised ones can now reach L[i]. _raised_max[l]
+  // holds the largest value raised from level l so far in the scan.
+  void push_back(int x) {
+    const int64_t NONE = std::numeric_limits<int64_t>::min();
+
+    _raised_max.assign(_length + 2, NONE);
+    _raised_max[0] = x;
+
+    for (size_t i = _values.size(); i-- > 0; ) {
+      uint32_t level = _starts[i];
+      if (_raised_max[level - 1] >= _values[i]) {
+        _starts[i] = level + 1;
+        if (_raised_max[level] < _values[i]) {
+          _raised_max[level] = _values[i];
+        }
+        _level_counts[level]--;
+        if (level + 1 >= _level_counts.size()) {
+          _level_counts.resize(level + 2, 0);
+        }
+        _level_counts[level + 1]++;
+        if (level + 1 > _length) {
+          _length = level + 1;
+        }
+      }
+    }
+
+    _values.push_back(x);
+    _starts.push_back(1);
+    if (_level_counts.size() < 2) {
+      _level_counts.resize(2, 0);
+    }
+    _level_counts[1]++;
+    if (_length < 1) {
+      _length = 1;
+    }
+  }
+
+  // Replace the window with values, in O(n log n) rather than the O(n^2)
+  // of pushing them one at a time.
+  void assign(const sequence& values) {
+    auto H = longest_nondecreasing_lengths(values);
+    _values.assign(values.begin(), values.end());
+    _starts.assign(H.begin(), H.end());
+    _length = H.empty() ? 0 : *std::max_element(H.begin(), H.end());
+    _level_counts.assign(_length + 1, 0);
+    for (auto level : H) {
+      _level_counts[level]++;
+    }
+  }
+
+  // Remove the oldest element.
+  void pop_front() {
+    assert(!empty());
+    _level_counts[_starts.front()]--;
+    _values.pop_front();
+    _starts.pop_front();
+    while (_length > 0 && _level_counts[_length] == 0) {
+      _length--;
+    }
+  }
+};
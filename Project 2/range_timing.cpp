@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// range_timing.cpp
+//
+// Builds an lnds_range_index over 10^6 elements and answers 10^6 random
+// subarray queries with it, against slicing each subarray and rerunning
+// the patience algorithm on it. Prints the build time and the average
+// time per query for each.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "timer.hpp"
+
+#include "lnds_range.hpp"
+#include "subsequence.hpp"
+
+void print_bar() {
+  std::cout << std::string(79, '-') << std::endl;
+}
+
+int main() {
+
+  const size_t n = 1000000, queries = 1000000, recomputed = 100;
+
+  // Use hardcoded seeds for reproducibility between runs.
+  auto input = random_sequence(n, 0, 1000000);
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<size_t> dist(0, n);
+  std::vector<std::pair<size_t, size_t>> ranges(queries);
+  for (auto& range : ranges) {
+    size_t a = dist(gen), b = dist(gen);
+    range = std::make_pair(std::min(a, b), std::max(a, b));
+  }
+
+  print_bar();
+  std::cout << "n = " << n << ", queries = " << queries << std::endl;
+  print_bar();
+
+  Timer timer;
+  lnds_range_index index(input);
+  double build_elapsed = timer.elapsed();
+  std::cout << "index build seconds = " << build_elapsed << std::endl;
+
+  size_t total = 0;
+  timer.reset();
+  for (auto& range : ranges) {
+    total += index.length(range.first, range.second);
+  }
+  double query_elapsed = timer.elapsed() / queries;
+  std::cout << "index seconds/query = " << query_elapsed
+            << " (sum of lengths " << total << ")" << std::endl;
+
+  timer.reset();
+  for (size_t q = 0; q < recomputed; ++q) {
+    sequence slice(input.begin() + ranges[q].first, input.begin() + ranges[q].second);
+    size_t expected = longest_nondecreasing_patience(slice).size();
+    assert(expected == index.length(ranges[q].first, ranges[q].second));
+    (void) expected;
+  }
+  double recompute_elapsed = timer.elapsed() / recomputed;
+  std::cout << "recompute seconds/query = " << recompute_elapsed
+            << " (first " << recomputed << " queries)" << std::endl;
+
+  print_bar();
+
+  return 0;
+}
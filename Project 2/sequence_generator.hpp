@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// sequence_generator.hpp
+//
+// Reproducible pseudorandom input sequences, generated in parallel.
+//
+// How to use:
+//
+//    std::vector<int> input(size);  // or any preallocated buffer
+//    fill_uniform(input.data(), size, seed, max_element);
+//    fill_sorted_with_noise(input.data(), size, seed, noise);
+//    fill_sawtooth(input.data(), size, seed, period, noise);
+//    fill_decreasing(input.data(), size, seed, noise);
+//
+// Element i is computed from the seed and i alone, with the SplitMix64
+// mixing function as a counter-based generator, so the buffer can be
+// split into chunks filled by different threads and the output is
+// bit-identical for a given seed whatever the number of threads, and
+// on every platform.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "work_stealing.hpp"
+
+// Buffers shorter than this many elements per thread are not worth
+// splitting further.
+const size_t GENERATOR_MIN_PER_THREAD = 1 << 16;
+
+namespace generator_detail {
+
+// SplitMix64 finalizer: a bijection on 64-bit values that mixes every
+// input bit into every output bit.
+inline uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Pseudorandom value in [0, range) from 64 random bits, by taking the
+// high half of a 128-bit product rather than a modulus. The bias is at
+// most range / 2^64.
+inline uint64_t below(uint64_t bits, uint64_t range) {
+  return uint64_t((__uint128_t(bits) * range) >> 64);
+}
+
+// Fill out[0, size) with value_at(i) for each i, in equal chunks on
+// thread_count threads (0 for one per core).
+template <typename ValueAt>
+void fill_parallel(int* out, size_t size, unsigned thread_count, ValueAt value_at) {
+  if (thread_count == 0) {
+    thread_count = default_thread_count();
+  }
+  const size_t chunks = std::max<size_t>(1, std::min<size_t>(thread_count,
+                                                             size / GENERATOR_MIN_PER_THREAD));
+
+  std::vector<std::function<void()>> tasks;
+  for (size_t t = 0; t < chunks; t++) {
+    size_t lo = size * t / chunks, hi = size * (t + 1) / chunks;
+    tasks.push_back([=]() {
+      for (size_t i = lo; i < hi; ++i) {
+        out[i] = value_at(i);
+      }
+    });
+  }
+  run_work_stealing(tasks, unsigned(chunks));
+}
+
+} // namespace generator_detail
+
+// The index-th pseudorandom 64-bit value of the stream for seed.
+uint64_t counter_random(uint64_t seed, uint64_t index) {
+  // distinct seeds start their counters far apart
+  return generator_detail::mix(generator_detail::mix(seed) + index * 0x9e3779b97f4a7c15ULL);
+}
+
+// Pseudorandom integer in [low, high] at index of the stream for seed.
+int counter_uniform(uint64_t seed, uint64_t index, int low, int high) {
+  assert(low <= high);
+  uint64_t range = uint64_t(int64_t(high) - low) + 1;
+  return int(low + int64_t(generator_detail::below(counter_random(seed, index), range)));
+}
+
+// Elements in [0, max_element], uniformly at random. max_element must be
+// non-negative.
+void fill_uniform(int* out, size_t size, uint64_t seed, int max_element,
+                  unsigned thread_count = 0) {
+  assert(max_element >= 0);
+  generator_detail::fill_parallel(out, size, thread_count, [=](uint64_t i) {
+    return counter_uniform(seed, i, 0, max_element);
+  });
+}
+
+// Element i is i plus a uniform offset in [-noise, noise], so the longest
+// non-decreasing subsequence covers most of the input.
+void fill_sorted_with_noise(int* out, size_t size, uint64_t seed, int noise,
+                            unsigned thread_count = 0) {
+  assert(noise >= 0);
+  assert(size <= size_t(INT_MAX - noise));
+  generator_detail::fill_parallel(out, size, thread_count, [=](uint64_t i) {
+    return int(i) + counter_uniform(seed, i, -noise, noise);
+  });
+}
+
+// Element i is i % period plus a uniform offset in [0, noise]: runs of
+// period elements that rise and then drop back to the bottom.
+void fill_sawtooth(int* out, size_t size, uint64_t seed, int period, int noise,
+                   unsigned thread_count = 0) {
+  assert(period > 0);
+  assert(noise >= 0 && noise <= INT_MAX - period);
+  generator_detail::fill_parallel(out, size, thread_count, [=](uint64_t i) {
+    return int(i % uint64_t(period)) + counter_uniform(seed, i, 0, noise);
+  });
+}
+
+// Element i is (size - 1 - i) * (noise + 1) plus a uniform offset in
+// [0, noise], so the input is strictly decreasing: the longest
+// non-decreasing subsequences have length 1, and every element is one.
+void fill_decreasing(int* out, size_t size, uint64_t seed, int noise,
+                     unsigned thread_count = 0) {
+  assert(noise >= 0);
+  assert(uint64_t(size) * (uint64_t(noise) + 1) <= uint64_t(INT_MAX) + 1);
+  generator_detail::fill_parallel(out, size, thread_count, [=](uint64_t i) {
+    return int((size - 1 - i) * (uint64_t(noise) + 1))
+           + counter_uniform(seed, i, 0, noise);
+  });
+}
@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+// sequence_io.hpp
+//
+// Reading sequences from files without copying them.
+//
+// How to use:
+//
+//    // raw little-endian int32_t or int64_t values, no header
+//    auto values = mapped_sequence<int64_t>::open("input.bin");
+//    longest_nondecreasing(values.begin(), values.end());
+//
+//    // integers separated by newlines or other whitespace
+//    std::vector<int32_t> parsed = read_integer_text<int32_t>("input.txt");
+//
+// mapped_sequence maps the file read-only and hands out plain pointers
+// into it, which the generic algorithms in subsequence.hpp take directly,
+// so a sequence of many gigabytes is paged in by the kernel as it is
+// scanned rather than copied into a second buffer. The text parser also
+// works from a mapping, and converts eight digits at a time with 64-bit
+// arithmetic.
+//
+// Malformed input throws std::runtime_error, and failing system calls
+// std::system_error. This header depends on POSIX mmap.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sequence_io_detail {
+
+inline bool little_endian_host() {
+  const uint16_t one = 1;
+  uint8_t first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+inline bool is_space(char c) {
+  return c == '\n' || c == ' ' || c == '\r' || c == '\t';
+}
+
+// Whether all eight bytes of chunk are ASCII digits: the high nibble of
+// each must be 3, and adding 6 must not carry out of the low nibble.
+inline bool eight_digits(uint64_t chunk) {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+          | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+         == 0x3333333333333333ULL;
+}
+
+// Value of the eight digits in chunk, loaded little-endian so the first
+// digit is the low byte, by combining neighbouring digits, then pairs,
+// then quads, with one multiply each.
+inline uint64_t parse_eight_digits(uint64_t chunk) {
+  chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+  chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+  return ((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+}
+
+} // namespace sequence_io_detail
+
+// Read-only view of a file of raw values of type T, in the host's
+// (little-endian) byte order.
+template <typename T>
+class mapped_sequence {
+private:
+  static_assert(std::is_arithmetic<T>::value, "mapped_sequence holds numbers");
+
+  int _fd;
+  const T* _values;
+  size_t _size;
+
+  [[noreturn]] static void fail(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  mapped_sequence()
+    : _fd(-1), _values(nullptr), _size(0) { }
+
+  void release() {
+    if (_values != nullptr) {
+      ::munmap(const_cast<T*>(_values), _size * sizeof(T));
+      _values = nullptr;
+    }
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+
+public:
+
+  static mapped_sequence open(const std::string& path) {
+    if (sizeof(T) > 1 && !sequence_io_detail::little_endian_host()) {
+      throw std::runtime_error("raw sequence files are little-endian");
+    }
+
+    mapped_sequence result;
+    result._fd = ::open(path.c_str(), O_RDONLY);
+    if (result._fd < 0) {
+      fail("open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(result._fd, &st) != 0) {
+      fail("stat " + path);
+    }
+    if (size_t(st.st_size) % sizeof(T) != 0) {
+      throw std::runtime_error(path + " is not a whole number of values");
+    }
+    result._size = size_t(st.st_size) / sizeof(T);
+
+    // mmap refuses empty mappings
+    if (result._size > 0) {
+      void* base = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE,
+                          result._fd, 0);
+      if (base == MAP_FAILED) {
+        fail("mmap " + path);
+      }
+      ::madvise(base, size_t(st.st_size), MADV_SEQUENTIAL);
+      result._values = static_cast<const T*>(base);
+    }
+    return result;
+  }
+
+  mapped_sequence(mapped_sequence&& other)
+    : _fd(other._fd), _values(other._values), _size(other._size) {
+      other._fd = -1;
+      other._values = nullptr;
+  }
+
+  mapped_sequence(const mapped_sequence&) = delete;
+  mapped_sequence& operator= (const mapped_sequence&) = delete;
+
+  ~mapped_sequence() {
+    release();
+  }
+
+  size_t size() const {
+    return _size;
+  }
+
+  bool empty() const {
+    return _size == 0;
+  }
+
+  const T* data() const {
+    return _values;
+  }
+
+  const T* begin() const {
+    return _values;
+  }
+
+  const T* end() const {
+    return _values + _size;
+  }
+
+  T operator[] (size_t i) const {
+    return _values[i];
+  }
+};
+
+// Write size values to path in the format mapped_sequence reads.
+template <typename T>
+void write_raw_sequence(const std::string& path, const T* values, size_t size) {
+  if (sizeof(T) > 1 && !sequence_io_detail::little_endian_host()) {
+    throw std::runtime_error("raw sequence files are little-endian");
+  }
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(values), std::streamsize(size * sizeof(T)));
+  if (!out) {
+    throw std::runtime_error("failed writing " + path);
+  }
+}
+
+// Parse the whitespace-separated decimal integers, each with an optional
+// leading '-', in [first, last).
+template <typename T>
+std::vector<T> parse_integers(const char* first, const char* last) {
+  using namespace sequence_io_detail;
+  static_assert(std::is_integral<T>::value && std::is_signed<T>::value,
+                "parse_integers reads signed integers");
+
+  const uint64_t max = uint64_t(std::numeric_limits<T>::max());
+  const bool swar = little_endian_host();
+
+  std::vector<T> result;
+  result.reserve(size_t(std::count(first, last, '\n')) + 1);
+
+  const char* p = first;
+  while (true) {
+    while (p < last && is_space(*p)) {
+      ++p;
+    }
+    if (p == last) {
+      break;
+    }
+
+    bool negative = (*p == '-');
+    if (negative) {
+      ++p;
+    }
+
+    // Leading zeros do not count towards the length. Then up to 16
+    // digits eight at a time, which cannot overflow, then the rest one at
+    // a time; 19 digits always fit in 64 bits.
+    const char* digits = p;
+    while (p < last && *p == '0') {
+      ++p;
+    }
+    const char* significant = p;
+    uint64_t value = 0;
+    while (swar && last - p >= 8 && p - significant < 16) {
+      uint64_t chunk;
+      std::memcpy(&chunk, p, 8);
+      if (!eight_digits(chunk)) {
+        break;
+      }
+      value = value * 100000000 + parse_eight_digits(chunk);
+      p += 8;
+    }
+    while (p < last && unsigned(*p - '0') < 10) {
+      if (p - significant == 19) {
+        throw std::runtime_error("integer out of range");
+      }
+      value = value * 10 + unsigned(*p - '0');
+      ++p;
+    }
+
+    if (p == digits || (p < last && !is_space(*p))) {
+      throw std::runtime_error("unexpected character in integer list");
+    }
+    if (value > max + (negative ? 1 : 0)) {
+      throw std::runtime_error("integer out of range");
+    }
+    result.push_back(negative ? T(0 - value) : T(value));
+  }
+
+  return result;
+}
+
+// Parse a text file of whitespace-separated integers, as parse_integers.
+template <typename T>
+std::vector<T> read_integer_text(const std::string& path) {
+  auto text = mapped_sequence<char>::open(path);
+  return parse_integers<T>(text.begin(), text.end());
+}
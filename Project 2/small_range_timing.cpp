@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// small_range_timing.cpp
+//
+// Compares longest_nondecreasing_lengths_bitset against the binary-search
+// patience lengths on inputs from random_sequence with small values of
+// max_element, for n from 10^5 to 10^7.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <functional>
+#include <iostream>
+
+#include "timer.hpp"
+
+#include "subsequence.hpp"
+
+void print_bar() {
+  std::cout << std::string(79, '-') << std::endl;
+}
+
+int main() {
+
+  print_bar();
+  std::cout << "n, max_element, binary search seconds, bitset seconds" << std::endl;
+  print_bar();
+
+  for (size_t n = 100000; n <= 10000000; n *= 10) {
+    for (int max_element : {10, 100, 1000, int(BITSET_MAX_VALUE_RANGE) - 1}) {
+      // Use a hardcoded seed for reproducibility between runs.
+      auto input = random_sequence(n, 0, max_element);
+
+      Timer timer;
+      auto searched = longest_subsequence_lengths(input.begin(), input.end(),
+                                                  std::less_equal<int>());
+      double search_elapsed = timer.elapsed();
+
+      timer.reset();
+      auto bitset = longest_nondecreasing_lengths_bitset(input, 0, max_element);
+      double bitset_elapsed = timer.elapsed();
+
+      assert(searched == bitset);
+
+      std::cout << n << ", "
+                << max_element << ", "
+                << search_elapsed << ", "
+                << bitset_elapsed << std::endl;
+    }
+  }
+
+  print_bar();
+
+  return 0;
+}
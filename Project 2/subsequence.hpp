@@ -1,19 +1,31 @@
 ///////////////////////////////////////////////////////////////////////////////
 // subsequence.hpp
 //
-// Two algorithms for solving the longest non-decreasing subsequence problem.
+// Algorithms for solving the longest non-decreasing subsequence problem,
+// and generic versions for other element types and orders.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
-#include <random>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <string>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+#include "sequence_generator.hpp"
+#include "work_stealing.hpp"
+
 using sequence = std::vector<int>;
 
 // Convert a sequence into a human-readable string useful for pretty-printing
@@ -35,19 +47,15 @@ std::string sequence_to_string(const sequence& seq) {
 
 // Generate a pseudorandom sequence of the given size, using the given
 // seed, where all elements are in the range [0, max_element]. max_element
-// must be non-negative.
+// must be non-negative. The elements are filled in parallel by
+// fill_uniform, and are the same for a given seed on every platform and
+// with any number of threads.
 sequence random_sequence(size_t size, unsigned seed, int max_element) {
 
     assert(max_element >= 0);
 
-    sequence result;
-
-    std::mt19937 gen(seed);
-    std::uniform_int_distribution<> dist(0, max_element);
-
-    for (size_t i = 0; i < size; ++i) {
-        result.push_back(dist(gen));
-    }
+    sequence result(size);
+    fill_uniform(result.data(), size, seed, max_element);
 
     return result;
 }
@@ -114,6 +122,401 @@ sequence longest_nondecreasing_end_to_beginning(const sequence& A) {
   return sequence(R.begin(), R.begin() + max);
 }
 
+namespace subsequence_detail {
+
+// First position in the sorted range [first, first + n) where
+// may_start(x, tails[p]) is false, given that it is true for a prefix.
+//
+// Generic version, for any value type.
+template <typename T, typename Compare>
+const T* first_not_extended(const T* first, size_t n, const T& x,
+                            Compare may_start, std::false_type) {
+  return std::partition_point(first, first + n,
+                              [&](const T& t) { return may_start(x, t); });
+}
+
+// Branch-free version for arithmetic values: the loop has a fixed trip
+// count and the comparison only selects a pointer, so it compiles to
+// conditional moves over contiguous memory rather than a mispredicted
+// branch at every step.
+template <typename T, typename Compare>
+const T* first_not_extended(const T* first, size_t n, const T& x,
+                            Compare may_start, std::true_type) {
+  if (n == 0) {
+    return first;
+  }
+  while (n > 1) {
+    size_t half = n / 2;
+    first = may_start(x, first[half - 1]) ? first + half : first;
+    n -= half;
+  }
+  return first + (may_start(x, *first) ? 1 : 0);
+}
+
+} // namespace subsequence_detail
+
+namespace subsequence_detail {
+
+// Store in H the lengths that longest_subsequence_lengths returns, using
+// tails as working space. Both only grow, so once they have room for n
+// elements this allocates nothing.
+template <typename RandomIt, typename Compare>
+void subsequence_lengths_into(RandomIt first, RandomIt last, Compare ordered,
+                              std::vector<uint32_t>& H,
+                              std::vector<typename std::iterator_traits<RandomIt>::value_type>& tails) {
+  using value_type = typename std::iterator_traits<RandomIt>::value_type;
+  using arithmetic = std::integral_constant<bool, std::is_arithmetic<value_type>::value>;
+
+  const size_t n = size_t(last - first);
+  // lengths go up to n, stored as uint32_t
+  assert(n < UINT32_MAX);
+
+  H.resize(n);
+  tails.clear();
+
+  for (size_t i = n; i-- > 0; ) {
+    const value_type& x = first[i];
+    size_t k = first_not_extended(tails.data(), tails.size(), x, ordered, arithmetic())
+               - tails.data();
+    H[i] = uint32_t(k) + 1;
+    if (k == tails.size()) {
+      tails.push_back(x);
+    } else {
+      tails[k] = x;
+    }
+  }
+}
+
+} // namespace subsequence_detail
+
+// For every i in [first, last), the length of the longest subsequence
+// that starts at element i and in which each element b may follow the
+// element a before it, meaning ordered(a, b) is true.
+//
+// ordered must be a strict weak order such as std::less (strictly
+// increasing), or the non-strict version of one such as std::less_equal
+// (non-decreasing). Elements are only read, through random-access
+// iterators, so plain pointers into an existing array work without any
+// copy. Runs in O(n log n) time.
+//
+// Going from the end to the beginning, tails[k] holds the best value that
+// starts a subsequence of length k+1 among the elements seen so far. The
+// tails that element i may precede form a prefix of tails, so the length
+// for element i is found by binary search: it is one more than the length
+// of that prefix.
+template <typename RandomIt, typename Compare>
+std::vector<uint32_t> longest_subsequence_lengths(RandomIt first, RandomIt last,
+                                                  Compare ordered) {
+  std::vector<uint32_t> H;
+  std::vector<typename std::iterator_traits<RandomIt>::value_type> tails;
+  subsequence_detail::subsequence_lengths_into(first, last, ordered, H, tails);
+  return H;
+}
+
+// Rebuild one longest subsequence of the elements starting at first from
+// H, the lengths that longest_subsequence_lengths would give for them,
+// front to back: each time take the first element that may follow the
+// previous one and starts a long enough subsequence. This picks the same
+// elements as longest_nondecreasing_end_to_beginning.
+template <typename RandomIt, typename Compare>
+std::vector<typename std::iterator_traits<RandomIt>::value_type>
+subsequence_from_lengths(RandomIt first, const std::vector<uint32_t>& H,
+                         Compare ordered) {
+  std::vector<typename std::iterator_traits<RandomIt>::value_type> R;
+  if (H.empty()) {
+    return R;
+  }
+
+  size_t need = *std::max_element(H.begin(), H.end());
+  R.reserve(need);
+  for (size_t i = 0; i < H.size() && need > 0; ++i) {
+    if (H[i] == need && (R.empty() || ordered(R.back(), first[i]))) {
+      R.push_back(first[i]);
+      need--;
+    }
+  }
+
+  return R;
+}
+
+// One longest subsequence of [first, last) in which ordered(a, b) holds
+// for every element a and the element b after it, in O(n log n) time.
+// See longest_subsequence_lengths for the requirements on ordered.
+template <typename RandomIt, typename Compare>
+std::vector<typename std::iterator_traits<RandomIt>::value_type>
+longest_subsequence(RandomIt first, RandomIt last, Compare ordered) {
+  return subsequence_from_lengths(first,
+                                  longest_subsequence_lengths(first, last, ordered),
+                                  ordered);
+}
+
+// Longest non-decreasing subsequence of [first, last), for any value type
+// with operator<=.
+template <typename RandomIt>
+std::vector<typename std::iterator_traits<RandomIt>::value_type>
+longest_nondecreasing(RandomIt first, RandomIt last) {
+  using value_type = typename std::iterator_traits<RandomIt>::value_type;
+  return longest_subsequence(first, last, std::less_equal<value_type>());
+}
+
+// Longest strictly increasing subsequence of [first, last), for any value
+// type with operator<.
+template <typename RandomIt>
+std::vector<typename std::iterator_traits<RandomIt>::value_type>
+longest_increasing(RandomIt first, RandomIt last) {
+  using value_type = typename std::iterator_traits<RandomIt>::value_type;
+  return longest_subsequence(first, last, std::less<value_type>());
+}
+
+// Working memory for longest_subsequence_indices, kept by the caller
+// between calls so that repeated calls on inputs no longer than the
+// longest one so far make no heap allocations. 4 + sizeof(T) bytes per
+// element at most.
+template <typename T>
+struct subsequence_scratch {
+  std::vector<uint32_t> lengths;
+  std::vector<T> tails;
+};
+
+// Store in indices the positions, relative to first, of the elements of
+// the subsequence longest_subsequence(first, last, ordered) returns,
+// without copying any of them. indices and scratch are overwritten, and
+// reuse their capacity. Positions and lengths are stored in 32 bits, so
+// the input must have fewer than 2^32 - 1 elements.
+template <typename RandomIt, typename Compare>
+void longest_subsequence_indices(RandomIt first, RandomIt last, Compare ordered,
+                                 subsequence_scratch<typename std::iterator_traits<RandomIt>::value_type>& scratch,
+                                 std::vector<uint32_t>& indices) {
+  assert(size_t(last - first) < UINT32_MAX);
+  const std::vector<uint32_t>& H = scratch.lengths;
+  subsequence_detail::subsequence_lengths_into(first, last, ordered,
+                                               scratch.lengths, scratch.tails);
+
+  // the longest subsequence is as long as the number of tails
+  size_t need = scratch.tails.size();
+  indices.clear();
+  for (size_t i = 0; i < H.size() && need > 0; ++i) {
+    if (H[i] == need && (indices.empty() || ordered(first[indices.back()], first[i]))) {
+      indices.push_back(uint32_t(i));
+      need--;
+    }
+  }
+}
+
+// Positions in A of the elements of longest_nondecreasing_patience(A).
+std::vector<uint32_t> longest_nondecreasing_indices(const sequence& A) {
+  subsequence_scratch<int> scratch;
+  std::vector<uint32_t> indices;
+  longest_subsequence_indices(A.begin(), A.end(), std::less_equal<int>(),
+                              scratch, indices);
+  return indices;
+}
+
+// Inputs whose values span at most this many integers use
+// longest_nondecreasing_lengths_bitset: one 64-bit word of 64-bit words.
+const int64_t BITSET_MAX_VALUE_RANGE = 64 * 64;
+
+// Same as longest_nondecreasing_lengths, for inputs whose values all lie
+// in [low, high], with high - low < BITSET_MAX_VALUE_RANGE, in O(n) time.
+//
+// The patience tails are kept as a count per value, plus a bitset of the
+// values with a nonzero count and one summary word with a bit for each
+// nonzero word of the bitset. Going from the end to the beginning, H[i]
+// is one more than the number of tails >= A[i]; that number only changes
+// at values that are tails, so it is stored there, as above[v], and read
+// from the first tail value >= A[i]. Adding A[i] sets above[A[i]] to H[i]
+// and takes one tail away from the largest tail value below A[i], which
+// leaves every other above[] alone. Each search is a masked bit scan of
+// one word of the bitset and, if that is empty, of the summary word, so
+// there is no data-dependent binary search.
+std::vector<uint32_t> longest_nondecreasing_lengths_bitset(const sequence& A,
+                                                           int low, int high) {
+  const size_t n = A.size();
+  assert(n < UINT32_MAX);
+  assert(low <= high && int64_t(high) - low < BITSET_MAX_VALUE_RANGE);
+
+  const size_t range = size_t(int64_t(high) - low) + 1;
+  const uint64_t ALL = ~uint64_t(0);
+  std::vector<uint64_t> present((range + 63) / 64, 0);
+  uint64_t summary = 0;
+  std::vector<uint32_t> counts(range, 0), above(range, 0);
+  std::vector<uint32_t> H(n);
+
+  for (size_t i = n; i-- > 0; ) {
+    assert(A[i] >= low && A[i] <= high);
+    const size_t x = size_t(int64_t(A[i]) - low);
+
+    // first tail value >= x
+    uint32_t at_least = 0;
+    size_t w = x / 64;
+    uint64_t word = present[w] & (ALL << (x % 64));
+    uint64_t words_after = (w == 63) ? 0 : summary & (ALL << (w + 1));
+    if (word != 0) {
+      at_least = above[w * 64 + __builtin_ctzll(word)];
+    } else if (words_after != 0) {
+      w = __builtin_ctzll(words_after);
+      at_least = above[w * 64 + __builtin_ctzll(present[w])];
+    }
+
+    H[i] = at_least + 1;
+    above[x] = H[i];
+    counts[x]++;
+    present[x / 64] |= uint64_t(1) << (x % 64);
+    summary |= uint64_t(1) << (x / 64);
+
+    // largest tail value < x loses one tail
+    if (x == 0) {
+      continue;
+    }
+    w = (x - 1) / 64;
+    word = present[w] & (ALL >> (63 - (x - 1) % 64));
+    uint64_t words_before = summary & ((uint64_t(1) << w) - 1);
+    size_t y;
+    if (word != 0) {
+      y = w * 64 + 63 - __builtin_clzll(word);
+    } else if (words_before != 0) {
+      w = 63 - __builtin_clzll(words_before);
+      y = w * 64 + 63 - __builtin_clzll(present[w]);
+    } else {
+      continue;
+    }
+    if (--counts[y] == 0) {
+      present[y / 64] &= ~(uint64_t(1) << (y % 64));
+      if (present[y / 64] == 0) {
+        summary &= ~(uint64_t(1) << (y / 64));
+      }
+    }
+  }
+
+  return H;
+}
+
+// For every i, the length of the longest non-decreasing subsequence of A
+// that starts at A[i], in O(n log n) time, or with
+// longest_nondecreasing_lengths_bitset when the values span at most
+// BITSET_MAX_VALUE_RANGE integers.
+std::vector<uint32_t> longest_nondecreasing_lengths(const sequence& A) {
+  if (!A.empty()) {
+    auto bounds = std::minmax_element(A.begin(), A.end());
+    if (int64_t(*bounds.second) - *bounds.first < BITSET_MAX_VALUE_RANGE) {
+      return longest_nondecreasing_lengths_bitset(A, *bounds.first, *bounds.second);
+    }
+  }
+  return longest_subsequence_lengths(A.begin(), A.end(), std::less_equal<int>());
+}
+
+// O(n log n) version of longest_nondecreasing_end_to_beginning, returning
+// the same subsequence.
+sequence longest_nondecreasing_patience(const sequence& A) {
+  return subsequence_from_lengths(A.begin(), longest_nondecreasing_lengths(A),
+                                  std::less_equal<int>());
+}
+
+namespace subsequence_detail {
+
+// The quadratic recurrence of longest_nondecreasing_end_to_beginning,
+// H[i] = 1 + max{H[j] : j > i, A[i] <= A[j]}, with no branch in the inner
+// loop.
+inline void quadratic_lengths_scalar(const int* A, uint32_t* H, size_t n) {
+  for (size_t i = n; i-- > 0; ) {
+    const int x = A[i];
+    uint32_t best = 0;
+    for (size_t j = i + 1; j < n; ++j) {
+      uint32_t h = (x <= A[j]) ? H[j] : 0;
+      best = (h > best) ? h : best;
+    }
+    H[i] = best + 1;
+  }
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define SUBSEQUENCE_HAVE_AVX2 1
+
+// Same as quadratic_lengths_scalar, eight j at a time: the H of lanes
+// where A[j] < A[i] are masked to zero, and the rest folded into a running
+// unsigned max. Compiled for AVX2 whatever the -m flags, so it must only
+// be called once cpu_has_avx2() says it is safe.
+__attribute__((target("avx2")))
+inline void quadratic_lengths_avx2(const int* A, uint32_t* H, size_t n) {
+  for (size_t i = n; i-- > 0; ) {
+    const int x = A[i];
+    const __m256i xs = _mm256_set1_epi32(x);
+    __m256i best8 = _mm256_setzero_si256();
+
+    size_t j = i + 1;
+    for (; j + 8 <= n; j += 8) {
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(A + j));
+      __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(H + j));
+      // lanes with x > A[j] cannot follow A[i]
+      __m256i smaller = _mm256_cmpgt_epi32(xs, a);
+      best8 = _mm256_max_epu32(best8, _mm256_andnot_si256(smaller, h));
+    }
+
+    // horizontal max of the eight lanes
+    __m128i best4 = _mm_max_epu32(_mm256_castsi256_si128(best8),
+                                  _mm256_extracti128_si256(best8, 1));
+    best4 = _mm_max_epu32(best4, _mm_shuffle_epi32(best4, _MM_SHUFFLE(1, 0, 3, 2)));
+    best4 = _mm_max_epu32(best4, _mm_shuffle_epi32(best4, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t best = uint32_t(_mm_cvtsi128_si32(best4));
+
+    for (; j < n; ++j) {
+      uint32_t h = (x <= A[j]) ? H[j] : 0;
+      best = (h > best) ? h : best;
+    }
+    H[i] = best + 1;
+  }
+}
+
+inline bool cpu_has_avx2() {
+  static const bool has = __builtin_cpu_supports("avx2");
+  return has;
+}
+
+#else
+
+#define SUBSEQUENCE_HAVE_AVX2 0
+
+inline bool cpu_has_avx2() {
+  return false;
+}
+
+#endif
+
+} // namespace subsequence_detail
+
+// Same lengths as longest_nondecreasing_lengths, computed with the O(n^2)
+// end-to-beginning recurrence. When vectorize is true and the processor
+// supports AVX2, the inner loop runs eight elements at a time; otherwise
+// it falls back to scalar code.
+//
+// For n up to a few thousand this can beat the O(n log n) algorithm,
+// since it streams over two arrays with no data-dependent branches;
+// crossover_timing measures where that stops being true.
+std::vector<uint32_t> longest_nondecreasing_lengths_quadratic(const sequence& A,
+                                                              bool vectorize = true) {
+  const size_t n = A.size();
+  assert(n < UINT32_MAX);
+
+  std::vector<uint32_t> H(n);
+#if SUBSEQUENCE_HAVE_AVX2
+  if (vectorize && subsequence_detail::cpu_has_avx2()) {
+    subsequence_detail::quadratic_lengths_avx2(A.data(), H.data(), n);
+    return H;
+  }
+#endif
+  subsequence_detail::quadratic_lengths_scalar(A.data(), H.data(), n);
+  return H;
+}
+
+// longest_nondecreasing_end_to_beginning using the lengths from
+// longest_nondecreasing_lengths_quadratic, returning the same subsequence.
+sequence longest_nondecreasing_vectorized(const sequence& A, bool vectorize = true) {
+  return subsequence_from_lengths(A.begin(),
+                                  longest_nondecreasing_lengths_quadratic(A, vectorize),
+                                  std::less_equal<int>());
+}
+
 sequence longest_nondecreasing_powerset(const sequence& A) {
   const size_t n = A.size();
   sequence best;
@@ -153,3 +556,202 @@ sequence longest_nondecreasing_powerset(const sequence& A) {
 
   return best;
 }
+
+// longest_nondecreasing_powerset_parallel splits its search into at least
+// this many tasks per thread, when the input has that many subsets, so
+// that the work-stealing threads stay busy.
+const size_t POWERSET_TASKS_PER_THREAD = 16;
+
+namespace subsequence_detail {
+
+// Visitor for powerset_search that ignores every candidate. Tests pass
+// their own to see which subsets a search builds.
+struct null_visit {
+  void operator()(const std::vector<size_t>&, size_t) { }
+};
+
+// Depth-first search behind the pruned powerset algorithms. Visits every
+// non-decreasing index stack that starts with prefix, in the same order as
+// longest_nondecreasing_powerset, and returns the first largest one,
+// which may be prefix itself. visit(chosen, k) is called for every stack
+// chosen[0..k) built beyond prefix.
+//
+// A branch is cut once even taking every remaining element could not beat
+// the best size found by this search, or could not at least tie with
+// *shared_best, the best size found by any search running alongside; a tie
+// is still explored since the earlier of two equal subsets must win.
+template <typename Visit>
+std::vector<size_t> powerset_search(const sequence& A,
+                                    const std::vector<size_t>& prefix,
+                                    const std::atomic<size_t>* shared_best,
+                                    Visit& visit) {
+  const size_t n = A.size(), base = prefix.size();
+
+  // chosen[0..k) are the indices of the current candidate; next[k] is the
+  // next index to try adding after them
+  std::vector<size_t> chosen(n), best(prefix), next(n + 1);
+  std::copy(prefix.begin(), prefix.end(), chosen.begin());
+  size_t k = base, best_size = base;
+  next[k] = (k == 0) ? 0 : chosen[k-1] + 1;
+  best.reserve(n);
+
+  while (true) {
+    size_t reachable = k + (n - std::min(n, next[k]));
+    if (next[k] < n && reachable > best_size &&
+        (shared_best == nullptr ||
+         reachable >= shared_best->load(std::memory_order_relaxed))) {
+      size_t j = next[k]++;
+      if (k == 0 || A[chosen[k-1]] <= A[j]) {
+        chosen[k] = j;
+        ++k;
+        next[k] = j + 1;
+        visit(chosen, k);
+        if (k > best_size) {
+          best_size = k;
+          best.assign(chosen.begin(), chosen.begin() + k);
+        }
+      }
+    }
+    else {
+      if (k == base) {
+        break;
+      }
+      k--;
+    }
+  }
+
+  return best;
+}
+
+std::vector<size_t> powerset_search(const sequence& A,
+                                    const std::vector<size_t>& prefix,
+                                    const std::atomic<size_t>* shared_best) {
+  null_visit visit;
+  return powerset_search(A, prefix, shared_best, visit);
+}
+
+// One piece of the parallel powerset search: the subset prefix alone when
+// leaf is set, otherwise every subset that starts with prefix.
+struct powerset_task {
+  std::vector<size_t> prefix;
+  bool leaf;
+};
+
+// Split the non-empty non-decreasing index stacks of A into disjoint
+// tasks, listed in the order the sequential search visits them.
+//
+// The depth is the smallest one with at least target stacks of that
+// length, or n. Every stack shorter than the depth is a leaf task, and
+// every stack of exactly that length is the root of one subtree task, so
+// each subset belongs to exactly one task and no subtree task holds more
+// than the subsets under its prefix.
+std::vector<powerset_task> powerset_tasks(const sequence& A, size_t target) {
+  const size_t n = A.size();
+
+  // ending[j] is the number of non-decreasing stacks of the current
+  // length whose last index is j, capped at target
+  std::vector<size_t> ending(n, 1);
+  size_t depth = 1, count = std::min(n, target);
+  while (count < target && depth < n) {
+    std::vector<size_t> longer(n, 0);
+    count = 0;
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t i = 0; i < j; ++i) {
+        if (A[i] <= A[j]) {
+          longer[j] = std::min(target, longer[j] + ending[i]);
+        }
+      }
+      count = std::min(target, count + longer[j]);
+    }
+    ending.swap(longer);
+    depth++;
+  }
+
+  std::vector<powerset_task> tasks;
+  std::vector<size_t> chosen;
+  // preorder, like the sequential search: a stack, then its extensions
+  std::function<void(size_t)> expand = [&](size_t from) {
+    for (size_t j = from; j < n; ++j) {
+      if (!chosen.empty() && A[chosen.back()] > A[j]) {
+        continue;
+      }
+      chosen.push_back(j);
+      tasks.push_back(powerset_task{chosen, chosen.size() < depth});
+      if (chosen.size() < depth) {
+        expand(j + 1);
+      }
+      chosen.pop_back();
+    }
+  };
+  expand(0);
+
+  return tasks;
+}
+
+sequence values_at(const sequence& A, const std::vector<size_t>& indices) {
+  sequence result(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    result[i] = A[indices[i]];
+  }
+  return result;
+}
+
+} // namespace subsequence_detail
+
+// Exhaustive search over the same subsets as longest_nondecreasing_powerset,
+// in the same order, returning the same subsequence, but without visiting
+// subsets that cannot matter.
+//
+// Candidates are index stacks built one element at a time, so a subset is
+// abandoned as soon as its newest element breaks the non-decreasing order
+// (every extension of it would too), and a branch is cut once even taking
+// every remaining element could not beat the best size found so far.
+sequence longest_nondecreasing_powerset_pruned(const sequence& A) {
+  return subsequence_detail::values_at(A,
+      subsequence_detail::powerset_search(A, std::vector<size_t>(), nullptr));
+}
+
+// Multi-threaded longest_nondecreasing_powerset_pruned, returning the same
+// subsequence, on thread_count threads (0 for one per core).
+//
+// powerset_tasks splits the subsets by a prefix of fixed length into
+// disjoint subtrees, enough of them that each holds a small share of the
+// search; the shorter prefixes are only evaluated as subsets themselves.
+// The tasks are listed in the order of the sequential search, so keeping
+// the first largest result in task order breaks ties the same way. The
+// tasks share the best size found so far to prune each other, and run on
+// work-stealing threads since the early tasks are larger than the late
+// ones.
+sequence longest_nondecreasing_powerset_parallel(const sequence& A,
+                                                 unsigned thread_count = 0) {
+  if (thread_count == 0) {
+    thread_count = default_thread_count();
+  }
+  const auto pieces = subsequence_detail::powerset_tasks(
+      A, POWERSET_TASKS_PER_THREAD * thread_count);
+
+  std::vector<std::vector<size_t>> results(pieces.size());
+  std::atomic<size_t> shared_best(0);
+  std::vector<std::function<void()>> tasks;
+  for (size_t t = 0; t < pieces.size(); ++t) {
+    if (pieces[t].leaf) {
+      results[t] = pieces[t].prefix;
+      shared_best = std::max(shared_best.load(), results[t].size());
+      continue;
+    }
+    tasks.push_back([&, t]() {
+      results[t] = subsequence_detail::powerset_search(A, pieces[t].prefix, &shared_best);
+      size_t size = results[t].size(), seen = shared_best.load();
+      while (size > seen && !shared_best.compare_exchange_weak(seen, size)) { }
+    });
+  }
+  run_work_stealing(tasks, thread_count);
+
+  std::vector<size_t> best;
+  for (auto& result : results) {
+    if (result.size() > best.size()) {
+      best = result;
+    }
+  }
+  return subsequence_detail::values_at(A, best);
+}
@@ -1,14 +1,32 @@
 ///////////////////////////////////////////////////////////////////////////////
 // subsequence_test.cpp
 //
-// Unit tests for subsequence.hpp
+// Unit tests for subsequence.hpp, benchmark_stats.hpp, lnds_count.hpp, lnds_dynamic.hpp,
+// lnds_range.hpp, lnds_stream.hpp, lnds_window.hpp, sequence_generator.hpp
+// and sequence_io.hpp
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
 
 #include "rubrictest.hpp"
 
+#include "benchmark_stats.hpp"
+#include "lnds_count.hpp"
+#include "lnds_dynamic.hpp"
+#include "lnds_range.hpp"
+#include "lnds_stream.hpp"
+#include "lnds_window.hpp"
+#include "sequence_generator.hpp"
+#include "sequence_io.hpp"
 #include "subsequence.hpp"
 
 int main() {
@@ -60,5 +78,595 @@ int main() {
          TEST_EQUAL("input7", solution7, longest_nondecreasing_powerset(input7));
 		   });
 
+  rubric.criterion("patience examples", 1,
+		   [&]() {
+         TEST_EQUAL("first input", solution1, longest_nondecreasing_patience(input1));
+         TEST_EQUAL("second input", solution2, longest_nondecreasing_patience(input2));
+         TEST_EQUAL("input3", solution3, longest_nondecreasing_patience(input3));
+         TEST_EQUAL("input4", solution4, longest_nondecreasing_patience(input4));
+         TEST_EQUAL("input5", solution5, longest_nondecreasing_patience(input5));
+         TEST_EQUAL("input6", solution6, longest_nondecreasing_patience(input6));
+         TEST_EQUAL("input7", solution7, longest_nondecreasing_patience(input7));
+         TEST_EQUAL("empty input", sequence(), longest_nondecreasing_patience(sequence()));
+		   });
+
+  rubric.criterion("patience matches end-to-beginning", 1,
+		   [&]() {
+         for (unsigned seed = 0; seed < 200; ++seed) {
+           auto input = random_sequence(1 + seed % 50, seed, (seed % 2) ? 10 : 1000);
+           TEST_EQUAL("random input",
+                      longest_nondecreasing_end_to_beginning(input),
+                      longest_nondecreasing_patience(input));
+         }
+		   });
+
+  rubric.criterion("bitset lengths match patience", 1,
+		   [&]() {
+         for (unsigned seed = 0; seed < 200; ++seed) {
+           int max_element = (seed % 4 == 0) ? 0 : int(seed * 20 % 4096);
+           auto input = random_sequence(1 + seed % 300, seed, max_element);
+           if (seed % 3 == 0) {
+             for (auto& x : input) {
+               x -= 2000;
+             }
+           }
+           auto expected = longest_subsequence_lengths(input.begin(), input.end(),
+                                                       std::less_equal<int>());
+           auto bounds = std::minmax_element(input.begin(), input.end());
+           TEST_TRUE("tight bounds",
+                     expected == longest_nondecreasing_lengths_bitset(input, *bounds.first,
+                                                                      *bounds.second));
+           int slack = (4095 - (*bounds.second - *bounds.first)) / 2;
+           TEST_TRUE("loose bounds",
+                     expected == longest_nondecreasing_lengths_bitset(input, *bounds.first - slack,
+                                                                      *bounds.first - slack + 4095));
+           TEST_TRUE("selected automatically", expected == longest_nondecreasing_lengths(input));
+         }
+
+         // values at the two ends of the range, so every search crosses words
+         sequence alternating;
+         for (int i = 0; i < 1000; ++i) {
+           alternating.push_back((i % 3) ? 4095 : i % 7);
+         }
+         TEST_TRUE("alternating",
+                   longest_subsequence_lengths(alternating.begin(), alternating.end(),
+                                               std::less_equal<int>())
+                   == longest_nondecreasing_lengths_bitset(alternating, 0, 4095));
+		   });
+
+  rubric.criterion("vectorized quadratic matches patience", 1,
+		   [&]() {
+         TEST_EQUAL("input2", solution2, longest_nondecreasing_vectorized(input2));
+         TEST_EQUAL("input7", solution7, longest_nondecreasing_vectorized(input7));
+         TEST_EQUAL("empty input", sequence(), longest_nondecreasing_vectorized(sequence()));
+         for (unsigned seed = 0; seed < 100; ++seed) {
+           // sizes around multiples of 8 exercise the scalar tail
+           auto input = random_sequence(1 + seed % 40 + (seed % 3) * 100, seed,
+                                        (seed % 2) ? 10 : 1000);
+           if (seed % 5 == 0) {
+             for (auto& x : input) {
+               x -= 500;
+             }
+           }
+           auto expected = longest_nondecreasing_lengths(input);
+           TEST_TRUE("vectorized lengths", expected == longest_nondecreasing_lengths_quadratic(input));
+           TEST_TRUE("scalar lengths", expected == longest_nondecreasing_lengths_quadratic(input, false));
+           TEST_EQUAL("subsequence", longest_nondecreasing_patience(input),
+                      longest_nondecreasing_vectorized(input));
+         }
+		   });
+
+  rubric.criterion("generic element types and comparators", 1,
+		   [&]() {
+         for (unsigned seed = 0; seed < 100; ++seed) {
+           auto input = random_sequence(1 + seed % 50, seed, (seed % 2) ? 10 : 1000);
+           std::vector<int64_t> wide(input.begin(), input.end());
+           auto found = longest_nondecreasing(wide.data(), wide.data() + wide.size());
+           TEST_EQUAL("int64 pointers match patience",
+                      longest_nondecreasing_patience(input),
+                      sequence(found.begin(), found.end()));
+
+           auto strict = longest_increasing(input.begin(), input.end());
+           TEST_TRUE("strictly increasing",
+                     std::adjacent_find(strict.begin(), strict.end(),
+                                        std::greater_equal<int>()) == strict.end());
+           std::vector<int> distinct(input);
+           std::sort(distinct.begin(), distinct.end());
+           distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+           std::vector<int> sorted(input);
+           std::sort(sorted.begin(), sorted.end());
+           TEST_TRUE("strict is no longer than non-strict",
+                     strict.size() <= longest_nondecreasing_patience(input).size());
+           TEST_TRUE("strict of sorted input is the distinct values",
+                     longest_increasing(sorted.begin(), sorted.end()) == distinct);
+         }
+
+         const double readings[] = {0.5, 0.25, 0.75, 0.75, 1.5, 1.0};
+         auto rising = longest_increasing(readings, readings + 6);
+         TEST_TRUE("doubles", rising == std::vector<double>({0.5, 0.75, 1.5}));
+
+         struct sample { uint32_t key; uint16_t tag; };
+         const sample samples[] = {{3, 0}, {1, 1}, {2, 2}, {2, 3}, {5, 4}};
+         auto by_key = longest_subsequence(samples, samples + 5,
+             [](const sample& a, const sample& b) { return a.key < b.key; });
+         TEST_EQUAL("structs by key", 3, by_key.size());
+         TEST_EQUAL("first struct", 1, by_key[0].tag);
+         TEST_EQUAL("last struct", 4, by_key[2].tag);
+		   });
+
+  rubric.criterion("pruned powerset matches powerset", 1,
+		   [&]() {
+         TEST_EQUAL("first input", solution1, longest_nondecreasing_powerset_pruned(input1));
+         TEST_EQUAL("second input", solution2, longest_nondecreasing_powerset_pruned(input2));
+         TEST_EQUAL("input3", solution3, longest_nondecreasing_powerset_pruned(input3));
+         TEST_EQUAL("input7", solution7, longest_nondecreasing_powerset_pruned(input7));
+         TEST_EQUAL("empty input", sequence(), longest_nondecreasing_powerset_pruned(sequence()));
+         for (unsigned seed = 0; seed < 100; ++seed) {
+           auto input = random_sequence(1 + seed % 16, seed, (seed % 2) ? 5 : 1000);
+           TEST_EQUAL("random input",
+                      longest_nondecreasing_powerset(input),
+                      longest_nondecreasing_powerset_pruned(input));
+         }
+		   });
+
+  rubric.criterion("parallel powerset matches powerset", 1,
+		   [&]() {
+         TEST_EQUAL("second input", solution2, longest_nondecreasing_powerset_parallel(input2));
+         TEST_EQUAL("input7", solution7, longest_nondecreasing_powerset_parallel(input7));
+         TEST_EQUAL("empty input", sequence(), longest_nondecreasing_powerset_parallel(sequence()));
+         for (unsigned threads : {1, 4}) {
+           for (unsigned seed = 0; seed < 100; ++seed) {
+             auto input = random_sequence(1 + seed % 16, seed, (seed % 2) ? 5 : 1000);
+             TEST_EQUAL("random input",
+                        longest_nondecreasing_powerset(input),
+                        longest_nondecreasing_powerset_parallel(input, threads));
+           }
+         }
+		   });
+
+  rubric.criterion("parallel powerset splits the work", 1,
+		   [&]() {
+         // the subsets each task builds, as bitmasks of their indices
+         struct record {
+           std::vector<uint64_t> masks;
+           void operator()(const std::vector<size_t>& chosen, size_t k) {
+             uint64_t mask = 0;
+             for (size_t i = 0; i < k; ++i) {
+               mask |= uint64_t(1) << chosen[i];
+             }
+             masks.push_back(mask);
+           }
+         };
+
+         for (unsigned seed = 0; seed < 10; ++seed) {
+           auto input = random_sequence(16, seed, (seed % 2) ? 5 : 1000);
+           auto tasks = subsequence_detail::powerset_tasks(input, 64);
+           TEST_GE("enough tasks", tasks.size(), 64);
+
+           record all;
+           size_t largest = 0;
+           for (auto& task : tasks) {
+             all(task.prefix, task.prefix.size());
+             if (!task.leaf) {
+               record inside;
+               subsequence_detail::powerset_search(input, task.prefix, nullptr, inside);
+               largest = std::max(largest, inside.masks.size() + 1);
+               all.masks.insert(all.masks.end(), inside.masks.begin(), inside.masks.end());
+             }
+           }
+
+           auto visited = all.masks.size();
+           std::sort(all.masks.begin(), all.masks.end());
+           TEST_TRUE("no subset visited twice",
+                     std::adjacent_find(all.masks.begin(), all.masks.end()) == all.masks.end());
+           TEST_LE("no task holds a quarter of the search", 4 * largest, visited);
+         }
+		   });
+
+  rubric.criterion("counting and listing longest subsequences", 1,
+		   [&]() {
+         for (unsigned seed = 0; seed < 100; ++seed) {
+           auto input = random_sequence(seed % 13, seed, (seed % 2) ? 4 : 1000);
+
+           // every subset of positions, by brute force
+           const size_t n = input.size();
+           size_t best_length = 0;
+           uint64_t best_count = 0;
+           for (uint32_t mask = 0; mask < (1u << n); ++mask) {
+             sequence chosen;
+             for (size_t i = 0; i < n; ++i) {
+               if (mask & (1u << i)) {
+                 chosen.push_back(input[i]);
+               }
+             }
+             if (!is_nondecreasing(chosen)) {
+               continue;
+             }
+             if (chosen.size() > best_length) {
+               best_length = chosen.size();
+               best_count = 0;
+             }
+             if (chosen.size() == best_length) {
+               best_count++;
+             }
+           }
+
+           auto counted = count_longest_nondecreasing(input);
+           TEST_EQUAL("length", best_length, counted.length);
+           TEST_EQUAL("count", best_count, counted.count);
+           TEST_TRUE("exact", counted.exact);
+
+           lnds_enumerator all(input);
+           sequence found;
+           uint64_t listed = 0;
+           std::vector<size_t> previous;
+           while (all.next(found)) {
+             listed++;
+             TEST_EQUAL("listed length", best_length, found.size());
+             TEST_TRUE("listed is non-decreasing", is_nondecreasing(found));
+             TEST_TRUE("listed in order", previous.empty() || previous < all.indices());
+             previous = all.indices();
+           }
+           TEST_EQUAL("listed count", best_count, listed);
+         }
+
+         // pairs 1 0, 3 2, 5 4, ...: one of each pair, 2^pairs ways
+         sequence pairs;
+         for (int k = 0; k < 40; ++k) {
+           pairs.push_back(2 * k + 1);
+           pairs.push_back(2 * k);
+         }
+         auto counted = count_longest_nondecreasing(pairs);
+         TEST_EQUAL("2^40 count", uint64_t(1) << 40, counted.count);
+         TEST_TRUE("2^40 exact", counted.exact);
+         for (int k = 40; k < 70; ++k) {
+           pairs.push_back(2 * k + 1);
+           pairs.push_back(2 * k);
+         }
+         counted = count_longest_nondecreasing(pairs);
+         TEST_EQUAL("2^70 length", 70, counted.length);
+         TEST_EQUAL("2^70 count modulo 2^64", 0, counted.count);
+         TEST_TRUE("2^70 not exact", !counted.exact);
+		   });
+
+  rubric.criterion("range queries", 1,
+		   [&]() {
+         lnds_range_index empty((sequence()));
+         TEST_EQUAL("empty sequence", 0, empty.length(0, 0));
+
+         for (unsigned seed = 0; seed < 60; ++seed) {
+           // long enough to split, with and without repeated values
+           auto input = random_sequence(seed * 3, seed, (seed % 3) ? 1000 : 5);
+           lnds_range_index index(input);
+           for (size_t first = 0; first <= input.size(); ++first) {
+             for (size_t last = first; last <= input.size(); ++last) {
+               sequence slice(input.begin() + first, input.begin() + last);
+               TEST_EQUAL("subarray length",
+                          longest_nondecreasing_patience(slice).size(),
+                          index.length(first, last));
+             }
+           }
+         }
+		   });
+
+  rubric.criterion("dynamic updates", 1,
+		   [&]() {
+         lnds_dynamic empty;
+         TEST_EQUAL("empty", 0, empty.length());
+
+         // end_to_beginning needs a non-empty input
+         auto reference = [](const sequence& A) -> size_t {
+           return A.empty() ? 0 : longest_nondecreasing_end_to_beginning(A).size();
+         };
+
+         for (unsigned seed = 0; seed < 20; ++seed) {
+           std::mt19937 gen(seed);
+           auto start = random_sequence(seed % 30, seed, 50);
+           lnds_dynamic dynamic(start);
+           sequence expected(start);
+           for (int op = 0; op < 300; ++op) {
+             int x = int(gen() % 50);
+             switch (gen() % 4) {
+             case 0:
+               dynamic.push_back(x);
+               expected.push_back(x);
+               break;
+             case 1:
+               if (!expected.empty()) {
+                 dynamic.pop_back();
+                 expected.pop_back();
+               }
+               break;
+             default:
+               if (!expected.empty()) {
+                 size_t i = gen() % expected.size();
+                 dynamic.set(i, x);
+                 expected[i] = x;
+               }
+               break;
+             }
+             // read the length only some of the time, so that updates pile up
+             if (gen() % 3 == 0) {
+               TEST_EQUAL("length", reference(expected), dynamic.length());
+             }
+           }
+           TEST_TRUE("values", expected == dynamic.values());
+           TEST_EQUAL("final length", reference(expected), dynamic.length());
+         }
+		   });
+
+  rubric.criterion("generated sequences", 1,
+		   [&]() {
+         // sizes that do not split evenly into chunks
+         const size_t size = 5 * GENERATOR_MIN_PER_THREAD + 7;
+         std::vector<int> one(size), many(size);
+         fill_uniform(one.data(), size, 42, 1000, 1);
+         for (unsigned threads : {2, 3, 8}) {
+           fill_uniform(many.data(), size, 42, 1000, threads);
+           TEST_TRUE("same for any thread count", one == many);
+         }
+         TEST_TRUE("in range", *std::min_element(one.begin(), one.end()) == 0
+                               && *std::max_element(one.begin(), one.end()) == 1000);
+         fill_uniform(many.data(), size, 43, 1000, 3);
+         TEST_TRUE("seed matters", one != many);
+         TEST_EQUAL("first value", counter_uniform(42, 0, 0, 1000), one[0]);
+         TEST_TRUE("random_sequence", random_sequence(size, 42, 1000) == one);
+
+         fill_sorted_with_noise(one.data(), size, 1, 5, 1);
+         fill_sorted_with_noise(many.data(), size, 1, 5, 3);
+         TEST_TRUE("sorted with noise reproducible", one == many);
+         bool close = true;
+         for (size_t i = 0; i < size; ++i) {
+           close = close && std::abs(one[i] - int(i)) <= 5;
+         }
+         TEST_TRUE("sorted with noise stays close", close);
+
+         fill_sawtooth(one.data(), size, 1, 100, 0, 2);
+         TEST_EQUAL("sawtooth", 57, one[1000 * 100 + 57]);
+
+         fill_decreasing(one.data(), size, 1, 3, 4);
+         TEST_TRUE("decreasing",
+                   std::adjacent_find(one.begin(), one.end(), std::less_equal<int>()) == one.end());
+		   });
+
+  rubric.criterion("streaming", 1,
+		   [&]() {
+         lnds_stream lengths_only;
+         lengths_only.push(input2);
+         TEST_EQUAL("length of second input", solution2.size(), lengths_only.length());
+
+         lnds_stream stream(true);
+         stream.push(input4);
+         TEST_EQUAL("input4 subsequence length", solution4.size(), stream.subsequence().size());
+         TEST_TRUE("input4 subsequence is non-decreasing", is_nondecreasing(stream.subsequence()));
+
+         // check the length after every value against the quadratic
+         // algorithm, with chunks small enough to spill
+         const std::string spill = "subsequence_test_spill.bin";
+         {
+           lnds_stream spilling(true, spill, 2, 8);
+           auto input = random_sequence(300, 7, 100);
+           for (size_t i = 0; i < input.size(); ++i) {
+             spilling.push(input[i]);
+             if (i % 37 == 0 || i + 1 == input.size()) {
+               sequence prefix(input.begin(), input.begin() + i + 1);
+               auto expected = longest_nondecreasing_end_to_beginning(prefix);
+               TEST_EQUAL("length so far", expected.size(), spilling.length());
+
+               auto found = spilling.subsequence();
+               TEST_EQUAL("subsequence length", expected.size(), found.size());
+               TEST_TRUE("subsequence is non-decreasing", is_nondecreasing(found));
+               size_t j = 0;
+               for (size_t k = 0; k < prefix.size() && j < found.size(); ++k) {
+                 if (prefix[k] == found[j]) {
+                   ++j;
+                 }
+               }
+               TEST_EQUAL("subsequence of the input", found.size(), j);
+             }
+           }
+         }
+
+         // 8-bit distances, so that the values following the 0 have their
+         // predecessor in the far lists, both in memory and spilled
+         {
+           basic_lnds_stream<uint8_t> narrow(true, spill, 2, 64);
+           sequence input(1, 0);
+           for (int k = 1000; k > 0; --k) {
+             input.push_back(k);
+           }
+           auto rest = random_sequence(500, 3, 2000);
+           input.insert(input.end(), rest.begin(), rest.end());
+           for (size_t i = 0; i < input.size(); ++i) {
+             narrow.push(input[i]);
+             if (i % 97 == 0 || i + 1 == input.size()) {
+               sequence prefix(input.begin(), input.begin() + i + 1);
+               auto found = narrow.subsequence();
+               TEST_EQUAL("narrow subsequence length",
+                          longest_nondecreasing_end_to_beginning(prefix).size(), found.size());
+               TEST_TRUE("narrow subsequence is non-decreasing", is_nondecreasing(found));
+               size_t j = 0;
+               for (size_t k = 0; k < prefix.size() && j < found.size(); ++k) {
+                 if (prefix[k] == found[j]) {
+                   ++j;
+                 }
+               }
+               TEST_EQUAL("narrow subsequence of the input", found.size(), j);
+             }
+           }
+         }
+         std::remove(spill.c_str());
+		   });
+
+  rubric.criterion("sliding window", 1,
+		   [&]() {
+         lnds_window empty;
+         TEST_EQUAL("empty window", 0, empty.length());
+
+         for (size_t width : {1, 2, 5, 17, 40}) {
+           auto input = random_sequence(200, unsigned(width), (width % 2) ? 10 : 1000);
+           lnds_window window;
+           for (size_t i = 0; i < input.size(); ++i) {
+             window.push_back(input[i]);
+             if (window.size() > width) {
+               window.pop_front();
+             }
+             sequence current(input.begin() + (i + 1 - window.size()), input.begin() + i + 1);
+             TEST_EQUAL("length matches end-to-beginning",
+                        longest_nondecreasing_end_to_beginning(current).size(),
+                        window.length());
+           }
+           lnds_window assigned;
+           assigned.assign(sequence(input.end() - window.size(), input.end()));
+           while (!window.empty()) {
+             TEST_EQUAL("assign matches pushes", window.length(), assigned.length());
+             window.pop_front();
+             assigned.pop_front();
+           }
+           TEST_EQUAL("emptied window", 0, window.length());
+         }
+		   });
+
+  rubric.criterion("file input", 1,
+		   [&]() {
+         const std::string path = "subsequence_test_input.bin";
+         auto input = random_sequence(1000, 11, 200);
+
+         std::vector<int32_t> narrow(input.begin(), input.end());
+         write_raw_sequence(path, narrow.data(), narrow.size());
+         {
+           auto mapped = mapped_sequence<int32_t>::open(path);
+           TEST_EQUAL("int32 size", input.size(), mapped.size());
+           TEST_TRUE("int32 values", std::equal(input.begin(), input.end(), mapped.begin()));
+           auto found = longest_nondecreasing(mapped.begin(), mapped.end());
+           TEST_TRUE("int32 subsequence",
+                     sequence(found.begin(), found.end()) == longest_nondecreasing_patience(input));
+         }
+
+         std::vector<int64_t> wide(input.begin(), input.end());
+         wide[3] = -(int64_t(1) << 40);
+         write_raw_sequence(path, wide.data(), wide.size());
+         {
+           auto mapped = mapped_sequence<int64_t>::open(path);
+           TEST_TRUE("int64 values", std::equal(wide.begin(), wide.end(), mapped.begin()));
+           TEST_EQUAL("int64 length", longest_nondecreasing(wide.begin(), wide.end()).size(),
+                      longest_nondecreasing(mapped.begin(), mapped.end()).size());
+         }
+
+         write_raw_sequence<int64_t>(path, nullptr, 0);
+         TEST_TRUE("empty file", mapped_sequence<int64_t>::open(path).empty());
+
+         bool threw = false;
+         write_raw_sequence(path, "abc", 3);
+         try {
+           mapped_sequence<int32_t>::open(path);
+         } catch (const std::runtime_error&) {
+           threw = true;
+         }
+         TEST_TRUE("partial value rejected", threw);
+         std::remove(path.c_str());
+
+         const std::string text = " 12\n-7\n123456789012345678\r\n0\t"
+                                  "-9223372036854775808 9223372036854775807\n";
+         std::vector<int64_t> expected = {12, -7, 123456789012345678LL, 0,
+                                          INT64_MIN, INT64_MAX};
+         TEST_TRUE("parse int64",
+                   parse_integers<int64_t>(text.data(), text.data() + text.size()) == expected);
+         TEST_TRUE("parse nothing", parse_integers<int32_t>(text.data(), text.data()).empty());
+
+         // leading zeros do not count towards the digit limit
+         const std::string padded = "000000000000000000042 -0000000000000000000000002147483648 000";
+         std::vector<int32_t> unpadded = {42, INT32_MIN, 0};
+         TEST_TRUE("leading zeros",
+                   parse_integers<int32_t>(padded.data(), padded.data() + padded.size()) == unpadded);
+
+         for (std::string bad : {"1 2x", "-", "2147483648", "12345678901234567890", "1,2",
+                                 "0000000000000000000012345678901234567890"}) {
+           threw = false;
+           try {
+             parse_integers<int32_t>(bad.data(), bad.data() + bad.size());
+           } catch (const std::runtime_error&) {
+             threw = true;
+           }
+           TEST_TRUE("malformed input rejected", threw);
+         }
+
+         const std::string text_path = "subsequence_test_input.txt";
+         std::string lines;
+         for (int x : input) {
+           lines += std::to_string(x) + "\n";
+         }
+         write_raw_sequence(text_path, lines.data(), lines.size());
+         auto parsed = read_integer_text<int32_t>(text_path);
+         TEST_TRUE("text file", std::equal(input.begin(), input.end(), parsed.begin())
+                                && parsed.size() == input.size());
+         std::remove(text_path.c_str());
+		   });
+
+  rubric.criterion("index output", 1,
+		   [&]() {
+         TEST_TRUE("empty input", longest_nondecreasing_indices(sequence()).empty());
+         for (const sequence* input : {&input1, &input2, &input4, &input7}) {
+           auto indices = longest_nondecreasing_indices(*input);
+           sequence chosen;
+           for (uint32_t i : indices) {
+             chosen.push_back((*input)[i]);
+           }
+           TEST_TRUE("same elements as patience", chosen == longest_nondecreasing_patience(*input));
+           TEST_TRUE("positions increase", std::is_sorted(indices.begin(), indices.end()));
+         }
+
+         // the same scratch and output for many calls
+         subsequence_scratch<int> scratch;
+         std::vector<uint32_t> indices;
+         auto large = random_sequence(2000, 5, 300);
+         longest_subsequence_indices(large.begin(), large.end(), std::less<int>(),
+                                     scratch, indices);
+         TEST_EQUAL("strictly increasing length",
+                    longest_increasing(large.begin(), large.end()).size(), indices.size());
+         const uint32_t* kept_indices = indices.data();
+         const uint32_t* kept_lengths = scratch.lengths.data();
+         for (unsigned seed = 0; seed < 20; ++seed) {
+           auto input = random_sequence(100 + 50 * seed, seed, 1000);
+           longest_subsequence_indices(input.begin(), input.end(), std::less_equal<int>(),
+                                       scratch, indices);
+           TEST_TRUE("matches the allocating version",
+                     indices == longest_nondecreasing_indices(input));
+         }
+         TEST_TRUE("buffers reused",
+                   kept_indices == indices.data() && kept_lengths == scratch.lengths.data());
+		   });
+
+  rubric.criterion("benchmark statistics", 1,
+		   [&]() {
+         auto close = [](double x, double y) { return std::fabs(x - y) < 1e-9; };
+
+         auto summary = summarize({5, 1, 4, 2, 3, 100});
+         TEST_EQUAL("count", 6, summary.count);
+         TEST_TRUE("median", close(3.5, summary.median));
+         TEST_TRUE("MAD ignores the outlier", close(1.5, summary.mad));
+         TEST_TRUE("min and max", close(1, summary.min) && close(100, summary.max));
+         TEST_TRUE("p10", close(1.5, summary.p10));
+         TEST_TRUE("single sample", close(7, summarize({7}).p90));
+
+         std::vector<double> n = {10, 100, 1000, 10000}, quadratic, doubling;
+         for (double x : n) {
+           quadratic.push_back(3e-9 * x * x);
+         }
+         auto power = fit_power_law(n, quadratic);
+         TEST_TRUE("power law exponent", close(2, power.slope));
+         TEST_TRUE("exact fit", close(1, power.r_squared));
+
+         std::vector<double> small = {10, 12, 14, 16};
+         for (double x : small) {
+           doubling.push_back(1e-6 * std::exp2(x));
+         }
+         TEST_TRUE("exponential base", close(1, fit_exponential(small, doubling).slope));
+
+         auto noisy = fit_line({0, 1, 2, 3}, {0, 2, 1, 3});
+         TEST_TRUE("noisy slope", close(0.8, noisy.slope));
+         TEST_TRUE("noisy r^2", noisy.r_squared > 0 && noisy.r_squared < 1);
+		   });
+
   return rubric.run();
 }
@@ -1,62 +1,441 @@
 ///////////////////////////////////////////////////////////////////////////////
 // subsequence_timing.cpp
 //
-// Example code showing how to run each algorithm while measuring
-// elapsed times precisely. You should modify this program to gather
-// all of your experimental data.  
+// Benchmark driver for the longest non-decreasing subsequence algorithms.
+// Runs each selected algorithm on random inputs over a range of sizes,
+// repeating every measurement, and reports the median time with its
+// spread, then fits the growth of the median time against n to compare
+// with the expected complexity.
+//
+// Usage:
+//
+//    subsequence_timing [--algorithms=NAME,NAME,...] [--sizes=FIRST:LAST:STEP]
+//                       [--repetitions=R] [--warmup=W] [--timeout=SECONDS]
+//                       [--format=text|csv|json] [--seed=S] [--max-element=M]
+//
+// STEP is either +K, adding K to n each time, or xK, multiplying n by K.
+// Without --sizes each algorithm uses a range suited to its complexity.
+// A size is skipped, along with every larger one, when a single run is
+// predicted from the previous size to take longer than the timeout, or
+// when its first run does; this is what stops the exponential powerset
+// algorithms.
+//
+// With --format=csv, only the measurements go to standard output, and the
+// fits are written to standard error.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-#include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
-#include <random>
+#include <string>
 #include <vector>
 
 #include "timer.hpp"
 
+#include "benchmark_stats.hpp"
 #include "subsequence.hpp"
 
 void print_bar() {
   std::cout << std::string(79, '-') << std::endl;
 }
 
-int main() {
+enum class growth { polynomial, exponential };
+
+struct size_range {
+  size_t first, last, step;
+  // multiply by step instead of adding it
+  bool geometric;
+};
+
+struct algorithm {
+  std::string name;
+  growth model;
+  // slope of the fit the complexity predicts, used to skip sizes that
+  // would exceed the timeout
+  double predicted_slope;
+  std::string expected;
+  size_range sizes;
+  std::function<size_t(const sequence&)> run;
+};
+
+struct measurement {
+  std::string algorithm;
+  size_t n;
+  sample_summary summary;
+};
+
+struct growth_fit {
+  std::string algorithm;
+  growth model;
+  std::string expected;
+  line_fit fit;
+  size_t points;
+  // largest size measured, and whether larger ones were skipped
+  size_t last_n;
+  bool timed_out;
+};
+
+struct options {
+  std::vector<std::string> algorithms;
+  bool custom_sizes = false;
+  size_range sizes;
+  size_t repetitions = 5;
+  size_t warmup = 1;
+  double timeout = 1.0;
+  std::string format = "text";
+  unsigned seed = 0;
+  int max_element = 1000;
+};
+
+std::vector<algorithm> all_algorithms() {
+  return {
+    {"end_to_beginning", growth::polynomial, 2, "n^2", {250, 4000, 2, true},
+     [](const sequence& A) { return longest_nondecreasing_end_to_beginning(A).size(); }},
+    {"vectorized", growth::polynomial, 2, "n^2", {250, 8000, 2, true},
+     [](const sequence& A) { return longest_nondecreasing_vectorized(A).size(); }},
+    {"patience", growth::polynomial, 1, "n log n", {1000, 1000000, 10, true},
+     [](const sequence& A) { return longest_nondecreasing_patience(A).size(); }},
+    {"powerset", growth::exponential, 1, "2^n", {10, 30, 2, false},
+     [](const sequence& A) { return longest_nondecreasing_powerset(A).size(); }},
+    {"powerset_pruned", growth::exponential, 1, "at most 2^n", {10, 40, 2, false},
+     [](const sequence& A) { return longest_nondecreasing_powerset_pruned(A).size(); }},
+    {"powerset_parallel", growth::exponential, 1, "2^n", {10, 30, 2, false},
+     [](const sequence& A) { return longest_nondecreasing_powerset_parallel(A).size(); }},
+  };
+}
+
+void print_usage(const std::vector<algorithm>& algorithms) {
+  std::cerr << "usage: subsequence_timing [--algorithms=NAME,NAME,...] [--sizes=FIRST:LAST:STEP]" << std::endl
+            << "                          [--repetitions=R] [--warmup=W] [--timeout=SECONDS]" << std::endl
+            << "                          [--format=text|csv|json] [--seed=S] [--max-element=M]" << std::endl
+            << "STEP is +K to add K to n, or xK to multiply n by K" << std::endl
+            << "algorithms:";
+  for (auto& a : algorithms) {
+    std::cerr << " " << a.name;
+  }
+  std::cerr << std::endl;
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (true) {
+    size_t end = text.find(separator, start);
+    parts.push_back(text.substr(start, end - start));
+    if (end == std::string::npos) {
+      return parts;
+    }
+    start = end + 1;
+  }
+}
+
+// Parse a whole string as a non-negative number, or return false.
+bool parse_number(const std::string& text, double& out) {
+  if (text.empty() || text[0] == '-') {
+    return false;
+  }
+  char* end;
+  out = std::strtod(text.c_str(), &end);
+  return *end == '\0' && std::isfinite(out);
+}
+
+bool parse_count(const std::string& text, size_t& out) {
+  double value;
+  if (!parse_number(text, value) || value != std::floor(value)) {
+    return false;
+  }
+  out = size_t(value);
+  return true;
+}
+
+bool parse_sizes(const std::string& text, size_range& out) {
+  auto parts = split(text, ':');
+  if (parts.size() != 3 || parts[2].empty()) {
+    return false;
+  }
+  out.geometric = (parts[2][0] == 'x');
+  if (!out.geometric && parts[2][0] != '+') {
+    return false;
+  }
+  return parse_count(parts[0], out.first)
+         && parse_count(parts[1], out.last)
+         && parse_count(parts[2].substr(1), out.step)
+         && out.first > 0
+         && out.first <= out.last
+         && (out.geometric ? out.step > 1 : out.step > 0);
+}
 
-  const size_t n = 20;
+bool parse_options(int argc, char* argv[], const std::vector<algorithm>& known,
+                   options& out) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    size_t equals = arg.find('=');
+    if (equals == std::string::npos) {
+      return false;
+    }
+    std::string key = arg.substr(0, equals), value = arg.substr(equals + 1);
+    double number;
 
-  assert(n > 0);
+    if (key == "--algorithms") {
+      out.algorithms = split(value, ',');
+      for (auto& name : out.algorithms) {
+        bool found = false;
+        for (auto& a : known) {
+          found = found || (a.name == name);
+        }
+        if (!found) {
+          std::cerr << "unknown algorithm " << name << std::endl;
+          return false;
+        }
+      }
+    } else if (key == "--sizes") {
+      if (!parse_sizes(value, out.sizes)) {
+        return false;
+      }
+      out.custom_sizes = true;
+    } else if (key == "--repetitions") {
+      if (!parse_count(value, out.repetitions) || out.repetitions == 0) {
+        return false;
+      }
+    } else if (key == "--warmup") {
+      if (!parse_count(value, out.warmup)) {
+        return false;
+      }
+    } else if (key == "--timeout") {
+      if (!parse_number(value, number) || number <= 0) {
+        return false;
+      }
+      out.timeout = number;
+    } else if (key == "--format") {
+      if (value != "text" && value != "csv" && value != "json") {
+        return false;
+      }
+      out.format = value;
+    } else if (key == "--seed") {
+      size_t seed;
+      if (!parse_count(value, seed)) {
+        return false;
+      }
+      out.seed = unsigned(seed);
+    } else if (key == "--max-element") {
+      size_t max_element;
+      if (!parse_count(value, max_element) || max_element > size_t(INT_MAX)) {
+        return false;
+      }
+      out.max_element = int(max_element);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Time of one run at size next predicted from one at size previous.
+double predict(const algorithm& a, size_t previous, double seconds, size_t next) {
+  if (a.model == growth::exponential) {
+    return seconds * std::exp2(a.predicted_slope * (double(next) - double(previous)));
+  }
+  return seconds * std::pow(double(next) / double(previous), a.predicted_slope);
+}
 
-  // Use a hardcoded seed for reproducibility between runs.
-  auto input = random_sequence(n, 0, 1000);
+// Results are summed here so that no run can be optimized away.
+volatile size_t result_sink = 0;
 
+// Measure a at every size of its range, appending to measurements, and
+// return the fit of the medians.
+growth_fit benchmark(const algorithm& a, const size_range& sizes, const options& opts,
+                     std::vector<measurement>& measurements) {
+  growth_fit result;
+  result.algorithm = a.name;
+  result.model = a.model;
+  result.expected = a.expected;
+  result.points = 0;
+  result.last_n = 0;
+  result.timed_out = false;
+
+  std::vector<double> ns, medians;
   Timer timer;
-  double elapsed;
-
-  print_bar();
-  std::cout << "n = " << n << std::endl
-            << sequence_to_string(input) << std::endl;
-
-  print_bar();
-  std::cout << "end to beginning" << std::endl;
-  timer.reset();
-  auto etb_output = longest_nondecreasing_end_to_beginning(input);
-  elapsed = timer.elapsed();
-  std::cout << "output = " << sequence_to_string(etb_output) << std::endl
-            << "of length = " << etb_output.size() << std::endl;
-  std::cout << "elapsed time=" << elapsed << " seconds" << std::endl;
-
-  print_bar();
-  std::cout << "powerset" << std::endl;
-  timer.reset();
-  auto powerset_output = longest_nondecreasing_powerset(input);
-  elapsed = timer.elapsed();
-  std::cout << "output = " << sequence_to_string(powerset_output) << std::endl
-            << "of length = " << powerset_output.size() << std::endl;
-  std::cout << "elapsed time=" << elapsed << " seconds" << std::endl;
-
-  print_bar();
+
+  for (size_t n = sizes.first; n <= sizes.last;
+       n = sizes.geometric ? n * sizes.step : n + sizes.step) {
+    if (result.last_n > 0
+        && predict(a, result.last_n, measurements.back().summary.median, n) > opts.timeout) {
+      result.timed_out = true;
+      break;
+    }
+
+    // The same seed at every size, for reproducibility between runs.
+    auto input = random_sequence(n, opts.seed, opts.max_element);
+
+    std::vector<double> samples;
+    for (size_t r = 0; r < opts.warmup + opts.repetitions; ++r) {
+      timer.reset();
+      result_sink = result_sink + a.run(input);
+      double elapsed = timer.elapsed();
+      if (r == 0 && elapsed > opts.timeout) {
+        // too slow to repeat; keep the one run
+        samples.push_back(elapsed);
+        result.timed_out = true;
+        break;
+      }
+      if (r >= opts.warmup) {
+        samples.push_back(elapsed);
+      }
+    }
+
+    measurement m;
+    m.algorithm = a.name;
+    m.n = n;
+    m.summary = summarize(samples);
+    measurements.push_back(m);
+
+    result.last_n = n;
+    if (m.summary.median > 0) {
+      ns.push_back(double(n));
+      medians.push_back(m.summary.median);
+    }
+    if (result.timed_out) {
+      break;
+    }
+  }
+
+  result.points = ns.size();
+  if (ns.size() >= 2) {
+    result.fit = (a.model == growth::exponential) ? fit_exponential(ns, medians)
+                                                  : fit_power_law(ns, medians);
+  }
+  return result;
+}
+
+void print_fit(std::ostream& out, const growth_fit& f) {
+  out << f.algorithm << ": ";
+  if (f.points < 2) {
+    out << "too few sizes to fit";
+  } else if (f.model == growth::exponential) {
+    out << "time ~ 2^(" << f.fit.slope << " n)";
+  } else {
+    out << "time ~ n^" << f.fit.slope;
+  }
+  if (f.points >= 2) {
+    out << " (expected " << f.expected << "), r^2 = " << f.fit.r_squared;
+  }
+  out << ", " << f.points << " sizes";
+  if (f.timed_out) {
+    out << ", stopped after n = " << f.last_n << " by the timeout";
+  }
+  out << std::endl;
+}
+
+void print_json(const options& opts, const std::vector<measurement>& measurements,
+                const std::vector<growth_fit>& fits) {
+  std::cout << "{" << std::endl
+            << "  \"settings\": {\"repetitions\": " << opts.repetitions
+            << ", \"warmup\": " << opts.warmup
+            << ", \"timeout_seconds\": " << opts.timeout
+            << ", \"seed\": " << opts.seed
+            << ", \"max_element\": " << opts.max_element << "}," << std::endl;
+
+  std::cout << "  \"measurements\": [" << std::endl;
+  for (size_t i = 0; i < measurements.size(); ++i) {
+    auto& m = measurements[i];
+    std::cout << "    {\"algorithm\": \"" << m.algorithm << "\""
+              << ", \"n\": " << m.n
+              << ", \"runs\": " << m.summary.count
+              << ", \"median\": " << m.summary.median
+              << ", \"mad\": " << m.summary.mad
+              << ", \"p10\": " << m.summary.p10
+              << ", \"p90\": " << m.summary.p90
+              << ", \"min\": " << m.summary.min
+              << ", \"max\": " << m.summary.max << "}"
+              << ((i + 1 < measurements.size()) ? "," : "") << std::endl;
+  }
+  std::cout << "  ]," << std::endl;
+
+  std::cout << "  \"fits\": [" << std::endl;
+  for (size_t i = 0; i < fits.size(); ++i) {
+    auto& f = fits[i];
+    std::cout << "    {\"algorithm\": \"" << f.algorithm << "\""
+              << ", \"model\": \""
+              << ((f.model == growth::exponential) ? "log2(time) ~ n" : "log(time) ~ log(n)") << "\""
+              << ", \"expected\": \"" << f.expected << "\""
+              << ", \"sizes\": " << f.points;
+    if (f.points >= 2) {
+      std::cout << ", \"slope\": " << f.fit.slope
+                << ", \"intercept\": " << f.fit.intercept
+                << ", \"r_squared\": " << f.fit.r_squared;
+    }
+    std::cout << ", \"last_n\": " << f.last_n
+              << ", \"timed_out\": " << (f.timed_out ? "true" : "false") << "}"
+              << ((i + 1 < fits.size()) ? "," : "") << std::endl;
+  }
+  std::cout << "  ]" << std::endl
+            << "}" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+  const auto known = all_algorithms();
+
+  options opts;
+  if (!parse_options(argc, argv, known, opts)) {
+    print_usage(known);
+    return 1;
+  }
+
+  std::vector<measurement> measurements;
+  std::vector<growth_fit> fits;
+
+  const bool text = (opts.format == "text");
+  if (text) {
+    print_bar();
+  }
+  if (opts.format != "json") {
+    std::cout << "algorithm, n, runs, median seconds, MAD seconds, p10 seconds, p90 seconds"
+              << std::endl;
+  }
+  if (text) {
+    print_bar();
+  }
+
+  for (auto& a : known) {
+    bool selected = opts.algorithms.empty();
+    for (auto& name : opts.algorithms) {
+      selected = selected || (name == a.name);
+    }
+    if (!selected) {
+      continue;
+    }
+
+    size_t first = measurements.size();
+    fits.push_back(benchmark(a, opts.custom_sizes ? opts.sizes : a.sizes, opts, measurements));
+
+    if (opts.format != "json") {
+      for (size_t i = first; i < measurements.size(); ++i) {
+        auto& m = measurements[i];
+        std::cout << m.algorithm << ", " << m.n << ", " << m.summary.count << ", "
+                  << m.summary.median << ", " << m.summary.mad << ", "
+                  << m.summary.p10 << ", " << m.summary.p90 << std::endl;
+      }
+    }
+  }
+
+  if (text) {
+    print_bar();
+    for (auto& f : fits) {
+      print_fit(std::cout, f);
+    }
+    print_bar();
+  } else if (opts.format == "csv") {
+    for (auto& f : fits) {
+      print_fit(std::cerr, f);
+    }
+  } else {
+    print_json(opts, measurements, fits);
+  }
 
   return 0;
 }
@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// window_timing.cpp
+//
+// Compares lnds_window against recomputing the longest non-decreasing
+// subsequence of every window from scratch, with the patience algorithm
+// and with end-to-beginning, for window widths from 10^3 to 10^6. Prints
+// the average time per slide (one push_back and one pop_front) for each.
+// End-to-beginning is quadratic in the width, so it is timed over fewer
+// slides, and only up to ETB_MAX_WIDTH.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cassert>
+#include <iostream>
+
+#include "timer.hpp"
+
+#include "lnds_window.hpp"
+#include "subsequence.hpp"
+
+void print_bar() {
+  std::cout << std::string(79, '-') << std::endl;
+}
+
+const size_t ETB_MAX_WIDTH = 10000;
+
+int main() {
+
+  const size_t slides = 200, etb_slides = 3;
+
+  print_bar();
+  std::cout << "width, window seconds/slide, patience seconds/slide, "
+            << "end-to-beginning seconds/slide" << std::endl;
+  print_bar();
+
+  for (size_t width = 1000; width <= 1000000; width *= 10) {
+    // Use a hardcoded seed for reproducibility between runs.
+    auto input = random_sequence(width + slides, 0, 1000000);
+
+    lnds_window window;
+    window.assign(sequence(input.begin(), input.begin() + width));
+
+    Timer timer;
+    for (size_t i = width; i < width + slides; ++i) {
+      window.push_back(input[i]);
+      window.pop_front();
+    }
+    double window_elapsed = timer.elapsed() / slides;
+
+    size_t check = 0;
+    timer.reset();
+    for (size_t i = width; i < width + slides; ++i) {
+      sequence current(input.begin() + (i + 1 - width), input.begin() + i + 1);
+      check = longest_nondecreasing_patience(current).size();
+    }
+    double recompute_elapsed = timer.elapsed() / slides;
+
+    assert(check == window.length());
+
+    std::cout << width << ", "
+              << window_elapsed << ", "
+              << recompute_elapsed << ", ";
+
+    if (width <= ETB_MAX_WIDTH) {
+      // the last etb_slides windows, ending with the current one
+      timer.reset();
+      for (size_t i = width + slides - etb_slides; i < width + slides; ++i) {
+        sequence current(input.begin() + (i + 1 - width), input.begin() + i + 1);
+        check = longest_nondecreasing_end_to_beginning(current).size();
+      }
+      double etb_elapsed = timer.elapsed() / etb_slides;
+      assert(check == window.length());
+      std::cout << etb_elapsed << std::endl;
+    } else {
+      std::cout << "skipped" << std::endl;
+    }
+  }
+
+  print_bar();
+
+  return 0;
+}